@@ -0,0 +1,312 @@
+#include "bmtree.h"
+#include "rbtree_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 한 구간 안의 서로 다른 키가 이만큼 모이면 dense 노드로 합치고, 이보다 적게 남으면 다시 쪼갠다.
+// 두 값 사이를 띄워서 경계에서 insert/erase가 반복될 때 합치기와 쪼개기가 번갈아 일어나지 않게 한다.
+#define BM_DENSE_MIN 8
+#define BM_SPARSE_MAX 4
+
+// 필요한 함수를 추가로 정의한다
+key_t chunk_base(const key_t key);
+bool in_chunk(const key_t base, const key_t key);
+bm_entry *find_entry(const bmtree *bt, const key_t key);
+bm_entry *lower_bound(const bmtree *bt, const key_t key);
+void insert_entry(bmtree *bt, bm_entry *e);
+void remove_entry(bmtree *bt, bm_entry *e);
+int insert_new_key(bmtree *bt, const key_t key);
+void split_dense(bmtree *bt, bm_dense *d);
+uint32_t dense_count_at(const bm_dense *d, const int off);
+
+bmtree *new_bmtree(void) {
+  bmtree *bt = (bmtree *)calloc(1, sizeof(bmtree));
+  if (!bt){
+    return NULL;
+  }
+  bt->tree = new_rbtree();
+  if (!bt->tree){
+    free(bt);
+    return NULL;
+  }
+  return bt;
+}
+
+void delete_bmtree(bmtree *bt) {
+  // dups는 rbtree가 모르는 메모리이므로 먼저 해제한다
+  rbtree *t = bt->tree;
+  for (node_t *p = rbtree_min(t); p != NULL; p = return_successor(t, p)){
+    if (((bm_entry *)p)->kind == BM_DENSE){
+      free(((bm_dense *)p)->dups);
+    }
+  }
+  delete_rbtree(t);
+  free(bt);
+}
+
+int bmtree_insert(bmtree *bt, const key_t key) {
+  bm_entry *e = find_entry(bt, key);
+  if (e == NULL){
+    return insert_new_key(bt, key);
+  }
+  if (e->kind == BM_DENSE){
+    bm_dense *d = (bm_dense *)e;
+    int off = key - e->node.key;
+    uint64_t bit = 1ULL << off;
+    // 이미 있는 키면 중복 개수를 따로 센다
+    if (d->bits & bit){
+      if (!d->dups){
+        d->dups = (uint32_t *)calloc(BM_SPAN, sizeof(uint32_t));
+        if (!d->dups){
+          return -1;
+        }
+      }
+      d->dups[off]++;
+    }
+    d->bits |= bit;
+  }
+  e->count++;
+  bt->size++;
+  return 0;
+}
+
+bool bmtree_find(const bmtree *bt, const key_t key) {
+  bm_entry *e = find_entry(bt, key);
+  if (e == NULL){
+    return false;
+  }
+  if (e->kind == BM_DENSE){
+    return (((bm_dense *)e)->bits >> (key - e->node.key)) & 1;
+  }
+  return true;
+}
+
+int bmtree_erase(bmtree *bt, const key_t key) {
+  bm_entry *e = find_entry(bt, key);
+  if (e == NULL){
+    return 0;
+  }
+  if (e->kind == BM_KEY){
+    bt->size--;
+    if (--e->count == 0){
+      remove_entry(bt, e);
+    }
+    return 1;
+  }
+
+  bm_dense *d = (bm_dense *)e;
+  int off = key - e->node.key;
+  if (!((d->bits >> off) & 1)){
+    return 0;
+  }
+  if (d->dups && d->dups[off] > 0){
+    d->dups[off]--;
+  }else{
+    d->bits &= ~(1ULL << off);
+  }
+  e->count--;
+  bt->size--;
+  // 서로 다른 키가 충분히 줄었으면 키 노드로 되돌린다
+  if (__builtin_popcountll(d->bits) < BM_SPARSE_MAX){
+    split_dense(bt, d);
+  }
+  return 1;
+}
+
+bool bmtree_min(const bmtree *bt, key_t *out) {
+  bm_entry *e = (bm_entry *)rbtree_min(bt->tree);
+  if (e == NULL){
+    return false;
+  }
+  // dense 노드의 가장 작은 키는 가장 낮은 비트이다
+  *out = e->kind == BM_DENSE ? e->node.key + __builtin_ctzll(((bm_dense *)e)->bits) : e->node.key;
+  return true;
+}
+
+bool bmtree_max(const bmtree *bt, key_t *out) {
+  bm_entry *e = (bm_entry *)rbtree_max(bt->tree);
+  if (e == NULL){
+    return false;
+  }
+  *out = e->kind == BM_DENSE ? e->node.key + (BM_SPAN - 1 - __builtin_clzll(((bm_dense *)e)->bits)) : e->node.key;
+  return true;
+}
+
+int bmtree_to_array(const bmtree *bt, key_t *arr, const size_t n) {
+  const rbtree *t = bt->tree;
+  size_t i = 0;
+  for (node_t *p = rbtree_min(t); p != NULL && i < n; p = return_successor(t, p)){
+    bm_entry *e = (bm_entry *)p;
+    if (e->kind == BM_KEY){
+      for (uint32_t c = 0; c < e->count && i < n; c++){
+        arr[i++] = e->node.key;
+      }
+      continue;
+    }
+    // 켜진 비트만 가장 낮은 것부터 하나씩 꺼내면서 쓴다
+    bm_dense *d = (bm_dense *)e;
+    for (uint64_t bits = d->bits; bits != 0 && i < n; bits &= bits - 1){
+      int off = __builtin_ctzll(bits);
+      uint32_t count = dense_count_at(d, off);
+      for (uint32_t c = 0; c < count && i < n; c++){
+        arr[i++] = e->node.key + off;
+      }
+    }
+  }
+  return 0;
+}
+
+// key가 속한 구간의 시작. 음수도 아래쪽으로 내림한다
+key_t chunk_base(const key_t key){
+  return key & ~(key_t)(BM_SPAN - 1);
+}
+
+// key가 base에서 시작하는 구간 안에 있는지 확인한다. 뺄셈이 넘치지 않도록 부호 없는 정수로 계산한다
+bool in_chunk(const key_t base, const key_t key){
+  return key >= base && (uint32_t)key - (uint32_t)base < BM_SPAN;
+}
+
+// key를 가진 키 노드나 key의 구간을 덮는 dense 노드를 찾는다.
+// 어떤 노드의 node.key도 다른 dense 노드 구간 안에 있지 않으므로, node.key 기준으로 내려가다 보면 반드시 만난다
+bm_entry *find_entry(const bmtree *bt, const key_t key){
+  const rbtree *t = bt->tree;
+  node_t *curr = t->root;
+  while (curr != t->nil){
+    bm_entry *e = (bm_entry *)curr;
+    if (key == curr->key || (e->kind == BM_DENSE && in_chunk(curr->key, key))){
+      return e;
+    }
+    curr = key < curr->key ? curr->left : curr->right;
+  }
+  return NULL;
+}
+
+// node.key가 key 이상인 첫 노드를 찾는다. 없으면 NULL
+bm_entry *lower_bound(const bmtree *bt, const key_t key){
+  const rbtree *t = bt->tree;
+  node_t *curr = t->root;
+  node_t *found = NULL;
+  while (curr != t->nil){
+    if (curr->key >= key){
+      found = curr;
+      curr = curr->left;
+    }else{
+      curr = curr->right;
+    }
+  }
+  return (bm_entry *)found;
+}
+
+// node.key는 노드끼리 겹치지 않으므로 rbtree_insert와 같이 내려가서 붙이기만 하면 된다
+void insert_entry(bmtree *bt, bm_entry *e){
+  rbtree *t = bt->tree;
+  node_t *curr = t->root;
+  node_t *parent = t->nil;
+  bool is_right = false;
+  while (curr != t->nil){
+    parent = curr;
+    is_right = e->node.key > curr->key;
+    curr = is_right ? curr->right : curr->left;
+  }
+  link_node(t, parent, &e->node, is_right);
+  if (e->kind == BM_DENSE){
+    bt->dense++;
+  }
+}
+
+// node가 첫 멤버이므로 rbtree_erase가 free하는 주소가 곧 노드 전체의 주소이다
+void remove_entry(bmtree *bt, bm_entry *e){
+  if (e->kind == BM_DENSE){
+    free(((bm_dense *)e)->dups);
+    bt->dense--;
+  }
+  rbtree_erase(bt->tree, &e->node);
+}
+
+// 트리에 없던 키를 넣는다. 같은 구간에 키 노드가 이미 충분히 모여 있으면 새 키까지 묶어서 dense 노드로 합친다
+int insert_new_key(bmtree *bt, const key_t key){
+  key_t base = chunk_base(key);
+  bm_entry *group[BM_SPAN];
+  int n = 0;
+  // 같은 구간의 키 노드들은 중위순회에서 연달아 나온다(구간 안에 dense 노드는 없다).
+  // dense 노드로 합칠 때 하나라도 남으면 안 되므로 구간 안의 키 노드를 모두 모은다(키마다 하나라 BM_SPAN개를 넘지 않는다)
+  for (bm_entry *e = lower_bound(bt, base); e != NULL && in_chunk(base, e->node.key);
+       e = (bm_entry *)return_successor(bt->tree, &e->node)){
+    group[n++] = e;
+  }
+
+  if (n + 1 >= BM_DENSE_MIN){
+    bm_dense *d = (bm_dense *)calloc(1, sizeof(bm_dense));
+    // 중복이 있는 키가 섞여 있으면 dups도 같이 만든다. 할당에 실패하면 그냥 키 노드로 넣는다
+    bool has_dups = false;
+    for (int i = 0; i < n; i++){
+      has_dups = has_dups || group[i]->count > 1;
+    }
+    if (d && has_dups){
+      d->dups = (uint32_t *)calloc(BM_SPAN, sizeof(uint32_t));
+      if (!d->dups){
+        free(d);
+        d = NULL;
+      }
+    }
+    if (d){
+      d->entry.kind = BM_DENSE;
+      d->entry.node.key = base;
+      d->entry.count = 1;
+      d->bits = 1ULL << (key - base);
+      for (int i = 0; i < n; i++){
+        int off = group[i]->node.key - base;
+        d->bits |= 1ULL << off;
+        if (group[i]->count > 1){
+          d->dups[off] = group[i]->count - 1;
+        }
+        d->entry.count += group[i]->count;
+        remove_entry(bt, group[i]);
+      }
+      insert_entry(bt, &d->entry);
+      bt->size++;
+      return 0;
+    }
+  }
+
+  bm_entry *e = (bm_entry *)calloc(1, sizeof(bm_entry));
+  if (!e){
+    return -1;
+  }
+  e->kind = BM_KEY;
+  e->node.key = key;
+  e->count = 1;
+  insert_entry(bt, e);
+  bt->size++;
+  return 0;
+}
+
+// dense 노드를 켜진 비트마다 키 노드 하나씩으로 되돌린다. 메모리가 부족하면 dense 노드를 그대로 둔다
+void split_dense(bmtree *bt, bm_dense *d){
+  bm_entry *keys[BM_SPARSE_MAX];
+  int n = 0;
+  for (uint64_t bits = d->bits; bits != 0; bits &= bits - 1){
+    int off = __builtin_ctzll(bits);
+    keys[n] = (bm_entry *)calloc(1, sizeof(bm_entry));
+    if (!keys[n]){
+      while (n > 0){
+        free(keys[--n]);
+      }
+      return;
+    }
+    keys[n]->kind = BM_KEY;
+    keys[n]->node.key = d->entry.node.key + off;
+    keys[n]->count = dense_count_at(d, off);
+    n++;
+  }
+  remove_entry(bt, &d->entry);
+  for (int i = 0; i < n; i++){
+    insert_entry(bt, keys[i]);
+  }
+}
+
+// 비트가 켜진 키의 개수(중복 포함)
+uint32_t dense_count_at(const bm_dense *d, const int off){
+  return 1 + (d->dups ? d->dups[off] : 0);
+}
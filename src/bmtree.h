@@ -0,0 +1,60 @@
+// 정수 키가 촘촘하게 몰려 있는 경우를 위한 하이브리드 트리.
+// 키 하나당 노드 하나를 쓰다가, 64개 단위 구간(chunk) 안에 키가 충분히 모이면
+// 구간 시작 키(base)와 비트맵 하나만 가진 dense 노드로 합치고, 다시 듬성해지면 키 노드로 쪼갠다.
+// 비트맵 안의 키는 노드가 따로 없으므로 node_t 포인터 대신 키와 개수로 주고받는다.
+#ifndef _BMTREE_H_
+#define _BMTREE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+
+// dense 노드 하나가 덮는 키 수. base는 항상 이 값의 배수이다
+#define BM_SPAN 64
+
+typedef enum {
+  BM_KEY,
+  BM_DENSE
+} bm_kind;
+
+// 두 종류 노드의 공통 머리. node는 반드시 첫 멤버여야 한다(node_t 포인터와 서로 바꿔 쓴다).
+// node.key는 키 노드면 그 키, dense 노드면 구간 시작(base)이다.
+// count는 이 노드가 가진 키의 개수(중복 포함)이다.
+typedef struct {
+  node_t node;
+  bm_kind kind;
+  uint32_t count;
+} bm_entry;
+
+// [base, base + BM_SPAN) 구간의 키를 비트맵으로 가진다.
+// 같은 키가 두 번 이상 들어오면 그때 dups를 할당해서 키마다 추가 개수를 센다.
+typedef struct {
+  bm_entry entry;
+  uint64_t bits;
+  uint32_t *dups;
+} bm_dense;
+
+// size는 중복을 포함한 전체 키 수, dense는 dense 노드 수이다.
+typedef struct {
+  rbtree *tree;
+  size_t size;
+  size_t dense;
+} bmtree;
+
+bmtree *new_bmtree(void);
+void delete_bmtree(bmtree *);
+
+// 키를 하나 추가한다. 같은 키도 하나 더 추가한다. 메모리가 부족하면 -1을 반환한다.
+int bmtree_insert(bmtree *, const key_t);
+bool bmtree_find(const bmtree *, const key_t);
+// 키를 하나 지운다. 지웠으면 1, 없었으면 0을 반환한다.
+int bmtree_erase(bmtree *, const key_t);
+// 최소/최대 키를 *out에 쓴다. 트리가 비어 있으면 false를 반환한다.
+bool bmtree_min(const bmtree *, key_t *);
+bool bmtree_max(const bmtree *, key_t *);
+// rbtree_to_array와 같이 키를 오름차순으로 최대 n개까지 배열에 쓴다.
+int bmtree_to_array(const bmtree *, key_t *, const size_t);
+
+#endif  // _BMTREE_H_
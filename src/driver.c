@@ -1,5 +1,339 @@
 #include "rbtree.h"
 
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// 운영 환경에서 수집한 연산 트레이스를 트리에 그대로 재생해서 성능을 재현하는 도구.
+//
+// 트레이스 파일 형식(리틀엔디안):
+//   헤더 16바이트: magic "RBTR", uint32 version(=1), uint64 레코드 수
+//   레코드 8바이트: uint8 op, 패딩 3바이트, int32 key
+// op는 아래 trace_op 값이고, min/max/to_array 레코드의 key는 쓰지 않는다.
+//
+// 사용법:
+//   driver [-w warmup] [-r repeat] trace     트레이스를 warmup번 버리고 repeat번 재생해서 측정한다
+//   driver -g n [-s seed] trace              무작위 연산 n개로 된 예제 트레이스를 만든다
+
+#define TRACE_MAGIC "RBTR"
+#define TRACE_VERSION 1
+// 지연시간 히스토그램은 2의 거듭제곱 ns 구간으로 나눈다. 구간 b는 [2^(b-1), 2^b) ns이다
+#define HIST_BUCKETS 48
+
+typedef enum {
+  OP_INSERT,
+  OP_FIND,
+  OP_ERASE,
+  OP_MIN,
+  OP_MAX,
+  OP_TO_ARRAY,
+  OP_COUNT
+} trace_op;
+
+static const char *op_names[OP_COUNT] = {"insert", "find", "erase", "min", "max", "to_array"};
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t count;
+} trace_header;
+
+typedef struct {
+  uint8_t op;
+  uint8_t pad[3];
+  int32_t key;
+} trace_record;
+
+// 연산 종류별 측정값. miss는 find/erase가 키를 못 찾은 횟수이다
+typedef struct {
+  uint64_t count;
+  uint64_t miss;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t hist[HIST_BUCKETS];
+} op_stats;
+
+// 필요한 함수를 추가로 정의한다
+int generate_trace(const char *path, uint64_t n, unsigned int seed);
+int replay(const trace_record *records, uint64_t n, op_stats *stats, rbtree **out);
+uint64_t now_ns(void);
+int hist_bucket(uint64_t ns);
+uint64_t hist_percentile(const op_stats *s, double q);
+int tree_height(const rbtree *t, const node_t *p);
+void print_report(const op_stats *stats, double seconds, int repeat, const rbtree *t);
+
 int main(int argc, char *argv[]) {
+  int warmup = 0;
+  int repeat = 1;
+  uint64_t generate = 0;
+  unsigned int seed = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "w:r:g:s:")) != -1){
+    switch (opt){
+    case 'w':
+      warmup = atoi(optarg);
+      break;
+    case 'r':
+      repeat = atoi(optarg);
+      break;
+    case 'g':
+      generate = strtoull(optarg, NULL, 10);
+      break;
+    case 's':
+      seed = (unsigned int)strtoul(optarg, NULL, 10);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-w warmup] [-r repeat] trace\n       %s -g n [-s seed] trace\n", argv[0], argv[0]);
+      return 2;
+    }
+  }
+  if (optind != argc - 1 || warmup < 0 || repeat < 1){
+    fprintf(stderr, "usage: %s [-w warmup] [-r repeat] trace\n       %s -g n [-s seed] trace\n", argv[0], argv[0]);
+    return 2;
+  }
+  const char *path = argv[optind];
+  if (generate > 0){
+    return generate_trace(path, generate, seed) == 0 ? 0 : 1;
+  }
+
+  // 트레이스를 mmap으로 읽는다
+  int fd = open(path, O_RDONLY);
+  if (fd < 0){
+    perror(path);
+    return 1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(trace_header)){
+    fprintf(stderr, "%s: not a trace file\n", path);
+    close(fd);
+    return 1;
+  }
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED){
+    perror("mmap");
+    return 1;
+  }
+  const trace_header *header = (const trace_header *)map;
+  uint64_t n = header->count;
+  if (memcmp(header->magic, TRACE_MAGIC, 4) != 0 || header->version != TRACE_VERSION ||
+      n > ((size_t)st.st_size - sizeof(trace_header)) / sizeof(trace_record)){
+    fprintf(stderr, "%s: bad header or truncated trace\n", path);
+    munmap(map, (size_t)st.st_size);
+    return 1;
+  }
+  const trace_record *records = (const trace_record *)(header + 1);
+  madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+  // 매 회차마다 빈 트리에서 시작해서 모든 회차가 같은 입력을 보게 한다. 워밍업 회차는 측정값을 버린다
+  op_stats stats[OP_COUNT];
+  rbtree *t = NULL;
+  double seconds = 0;
+  for (int round = 0; round < warmup + repeat; round++){
+    if (round == warmup){
+      memset(stats, 0, sizeof(stats));
+      seconds = 0;
+    }
+    if (t){
+      delete_rbtree(t);
+      t = NULL;
+    }
+    uint64_t start = now_ns();
+    if (replay(records, n, stats, &t) != 0){
+      fprintf(stderr, "replay failed: out of memory\n");
+      munmap(map, (size_t)st.st_size);
+      return 1;
+    }
+    seconds += (now_ns() - start) / 1e9;
+  }
+  print_report(stats, seconds, repeat, t);
+
+  delete_rbtree(t);
+  munmap(map, (size_t)st.st_size);
+  return 0;
+}
+
+// 새 트리에 레코드를 순서대로 적용하고 연산별 지연시간을 stats에 더한다. 마지막 트리는 *out으로 넘긴다
+int replay(const trace_record *records, uint64_t n, op_stats *stats, rbtree **out){
+  rbtree *t = new_rbtree();
+  if (!t){
+    return -1;
+  }
+  key_t *arr = NULL;
+  size_t arr_cap = 0;
+  for (uint64_t i = 0; i < n; i++){
+    const trace_record *r = &records[i];
+    if (r->op >= OP_COUNT){
+      continue;
+    }
+    // to_array의 출력 배열은 시간을 재기 전에 준비해둔다
+    if (r->op == OP_TO_ARRAY && arr_cap < t->size){
+      free(arr);
+      arr_cap = t->size;
+      arr = (key_t *)malloc(arr_cap * sizeof(key_t));
+      if (!arr){
+        delete_rbtree(t);
+        return -1;
+      }
+    }
+    bool hit = true;
+    uint64_t start = now_ns();
+    switch (r->op){
+    case OP_INSERT:
+      hit = rbtree_insert(t, r->key) != NULL;
+      break;
+    case OP_FIND:
+      hit = rbtree_find(t, r->key) != NULL;
+      break;
+    case OP_ERASE: {
+      node_t *p = rbtree_find(t, r->key);
+      hit = p != NULL;
+      if (hit){
+        rbtree_erase(t, p);
+      }
+      break;
+    }
+    case OP_MIN:
+      hit = rbtree_min(t) != NULL;
+      break;
+    case OP_MAX:
+      hit = rbtree_max(t) != NULL;
+      break;
+    case OP_TO_ARRAY:
+      rbtree_to_array(t, arr, t->size);
+      break;
+    }
+    uint64_t ns = now_ns() - start;
+
+    op_stats *s = &stats[r->op];
+    s->count++;
+    s->miss += !hit;
+    s->total_ns += ns;
+    if (ns > s->max_ns){
+      s->max_ns = ns;
+    }
+    s->hist[hist_bucket(ns)]++;
+  }
+  free(arr);
+  *out = t;
+  return 0;
+}
+
+// 키 범위를 좁혀서 find/erase가 적당히 맞도록 한 무작위 트레이스를 만든다
+int generate_trace(const char *path, uint64_t n, unsigned int seed){
+  FILE *f = fopen(path, "wb");
+  if (!f){
+    perror(path);
+    return -1;
+  }
+  trace_header header = {.version = TRACE_VERSION, .count = n};
+  memcpy(header.magic, TRACE_MAGIC, 4);
+  fwrite(&header, sizeof(header), 1, f);
+  srand(seed);
+  int32_t range = n > 2 ? (int32_t)(n / 2 < INT32_MAX ? n / 2 : INT32_MAX) : 1;
+  for (uint64_t i = 0; i < n; i++){
+    // insert 40%, find 35%, erase 20%, min 2.5%, max 2.4%, to_array 0.1%
+    int dice = rand() % 1000;
+    trace_record r = {.key = rand() % range};
+    r.op = dice < 400 ? OP_INSERT : dice < 750 ? OP_FIND : dice < 950 ? OP_ERASE : dice < 975 ? OP_MIN : dice < 999 ? OP_MAX : OP_TO_ARRAY;
+    fwrite(&r, sizeof(r), 1, f);
+  }
+  if (fclose(f) != 0){
+    perror(path);
+    return -1;
+  }
+  return 0;
+}
+
+uint64_t now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ns의 비트 수가 곧 구간 번호이다(0ns는 0번 구간)
+int hist_bucket(uint64_t ns){
+  int b = 0;
+  while (ns > 0 && b < HIST_BUCKETS - 1){
+    ns >>= 1;
+    b++;
+  }
+  return b;
+}
+
+// 히스토그램에서 q 분위수가 속한 구간의 상한을 반환한다
+uint64_t hist_percentile(const op_stats *s, double q){
+  uint64_t target = (uint64_t)(q * (double)s->count);
+  uint64_t seen = 0;
+  for (int b = 0; b < HIST_BUCKETS; b++){
+    seen += s->hist[b];
+    if (seen > target){
+      return b == 0 ? 0 : (1ULL << b) - 1;
+    }
+  }
+  return s->max_ns;
+}
+
+int tree_height(const rbtree *t, const node_t *p){
+  if (p == t->nil){
+    return 0;
+  }
+  int l = tree_height(t, p->left);
+  int r = tree_height(t, p->right);
+  return 1 + (l > r ? l : r);
+}
+
+void print_report(const op_stats *stats, double seconds, int repeat, const rbtree *t){
+  uint64_t total = 0;
+  for (int op = 0; op < OP_COUNT; op++){
+    total += stats[op].count;
+  }
+  printf("replayed %llu ops in %.3f s over %d round(s): %.0f ops/s\n",
+         (unsigned long long)total, seconds, repeat, seconds > 0 ? total / seconds : 0.0);
+  printf("final tree: size %zu, height %d\n\n", t->size, tree_height(t, t->root));
+
+  printf("%-9s %12s %10s %10s %10s %10s %10s\n", "op", "count", "miss", "mean(ns)", "p50(ns)", "p99(ns)", "max(ns)");
+  for (int op = 0; op < OP_COUNT; op++){
+    const op_stats *s = &stats[op];
+    if (s->count == 0){
+      continue;
+    }
+    printf("%-9s %12llu %10llu %10.0f %10llu %10llu %10llu\n", op_names[op],
+           (unsigned long long)s->count, (unsigned long long)s->miss, (double)s->total_ns / s->count,
+           (unsigned long long)hist_percentile(s, 0.50), (unsigned long long)hist_percentile(s, 0.99),
+           (unsigned long long)s->max_ns);
+  }
 
-}
\ No newline at end of file
+  // 연산별 지연시간 분포. 구간 상한(ns)마다 해당 연산 수를 보여준다
+  printf("\nlatency histogram (ops with latency < bound)\n");
+  printf("%12s", "bound(ns)");
+  for (int op = 0; op < OP_COUNT; op++){
+    if (stats[op].count){
+      printf(" %10s", op_names[op]);
+    }
+  }
+  printf("\n");
+  for (int b = 0; b < HIST_BUCKETS; b++){
+    bool any = false;
+    for (int op = 0; op < OP_COUNT; op++){
+      any = any || stats[op].hist[b];
+    }
+    if (!any){
+      continue;
+    }
+    printf("%12llu", 1ULL << b);
+    for (int op = 0; op < OP_COUNT; op++){
+      if (stats[op].count){
+        printf(" %10llu", (unsigned long long)stats[op].hist[b]);
+      }
+    }
+    printf("\n");
+  }
+}
@@ -0,0 +1,132 @@
+#include "fctree.h"
+#include "rbtree_internal.h"
+
+#include <stdlib.h>
+#include <sched.h>
+
+// 필요한 함수를 추가로 정의한다
+int submit(fctree *ft, const int slot, const fc_op op, const key_t key);
+void combine(fctree *ft);
+void sort_batch(fctree *ft, const int n);
+
+fctree *new_fctree(const int nslots) {
+  fctree *ft = (fctree *)calloc(1, sizeof(fctree));
+  if (!ft){
+    return NULL;
+  }
+  ft->tree = new_rbtree();
+  ft->slots = (fc_slot *)aligned_alloc(64, (size_t)nslots * sizeof(fc_slot));
+  ft->batch = (int *)malloc((size_t)nslots * sizeof(int));
+  if (!ft->tree || !ft->slots || !ft->batch){
+    if (ft->tree){
+      delete_rbtree(ft->tree);
+    }
+    free(ft->slots);
+    free(ft->batch);
+    free(ft);
+    return NULL;
+  }
+  for (int i = 0; i < nslots; i++){
+    atomic_init(&ft->slots[i].pending, false);
+  }
+  ft->nslots = nslots;
+  atomic_init(&ft->combining, false);
+  atomic_init(&ft->registered, 0);
+  return ft;
+}
+
+void delete_fctree(fctree *ft) {
+  delete_rbtree(ft->tree);
+  free(ft->slots);
+  free(ft->batch);
+  free(ft);
+}
+
+int fctree_register(fctree *ft) {
+  int slot = atomic_fetch_add(&ft->registered, 1);
+  return slot < ft->nslots ? slot : -1;
+}
+
+int fctree_insert(fctree *ft, const int slot, const key_t key) {
+  return submit(ft, slot, FC_INSERT, key);
+}
+
+int fctree_find(fctree *ft, const int slot, const key_t key) {
+  return submit(ft, slot, FC_FIND, key);
+}
+
+int fctree_erase(fctree *ft, const int slot, const key_t key) {
+  return submit(ft, slot, FC_ERASE, key);
+}
+
+// 연산을 슬롯에 올리고, 누군가(자기 자신일 수도 있다) 처리해줄 때까지 기다린다
+int submit(fctree *ft, const int slot, const fc_op op, const key_t key){
+  fc_slot *s = &ft->slots[slot];
+  s->op = op;
+  s->key = key;
+  atomic_store_explicit(&s->pending, true, memory_order_release);
+
+  while (atomic_load_explicit(&s->pending, memory_order_acquire)){
+    // combiner 자리가 비어 있으면 직접 맡는다. 내 연산은 이미 올려뒀으므로 이번 combine에 포함된다
+    if (!atomic_load_explicit(&ft->combining, memory_order_relaxed) &&
+        !atomic_exchange_explicit(&ft->combining, true, memory_order_acquire)){
+      combine(ft);
+      atomic_store_explicit(&ft->combining, false, memory_order_release);
+    }else{
+      sched_yield();
+    }
+  }
+  return s->result;
+}
+
+// 밀린 연산을 모두 모아서 키 순서로 적용한다.
+// 스레드마다 밀린 연산은 최대 하나이므로, 서로 다른 스레드의 연산 순서를 바꿔도 결과는 어떤 순차 실행과 같다.
+void combine(fctree *ft){
+  int n = 0;
+  int registered = atomic_load_explicit(&ft->registered, memory_order_relaxed);
+  if (registered > ft->nslots){
+    registered = ft->nslots;
+  }
+  for (int i = 0; i < registered; i++){
+    if (atomic_load_explicit(&ft->slots[i].pending, memory_order_acquire)){
+      ft->batch[n++] = i;
+    }
+  }
+  sort_batch(ft, n);
+
+  // 정렬된 삽입이 이어지면 직전에 넣은 노드 근처에서부터 자리를 찾는다. 지우기가 끼면 hint가 사라질 수 있으므로 초기화한다
+  rbtree *t = ft->tree;
+  node_t *hint = t->nil;
+  for (int i = 0; i < n; i++){
+    fc_slot *s = &ft->slots[ft->batch[i]];
+    if (s->op == FC_INSERT){
+      node_t *p = insert_node(t, hint, s->key);
+      s->result = p ? 0 : -1;
+      hint = p ? p : t->nil;
+    }else if (s->op == FC_FIND){
+      s->result = rbtree_find(t, s->key) != NULL;
+    }else{
+      node_t *p = rbtree_find(t, s->key);
+      s->result = p != NULL;
+      if (p){
+        rbtree_erase(t, p);
+        hint = t->nil;
+      }
+    }
+    atomic_store_explicit(&s->pending, false, memory_order_release);
+  }
+}
+
+// 밀린 연산 수는 스레드 수 이하라 작으므로 삽입 정렬로 충분하다
+void sort_batch(fctree *ft, const int n){
+  for (int i = 1; i < n; i++){
+    int slot = ft->batch[i];
+    key_t key = ft->slots[slot].key;
+    int j = i - 1;
+    while (j >= 0 && ft->slots[ft->batch[j]].key > key){
+      ft->batch[j + 1] = ft->batch[j];
+      j--;
+    }
+    ft->batch[j + 1] = slot;
+  }
+}
@@ -0,0 +1,51 @@
+// 여러 스레드가 트리 하나를 같이 쓰기 위한 flat-combining 앞단.
+// 각 스레드는 자기 슬롯에 연산을 올려두고, 그 중 combiner 역할을 잡은 스레드 하나가
+// 밀린 연산을 키 순서로 정렬해서 한 번에 트리에 적용한 뒤 결과를 슬롯에 돌려준다.
+#ifndef _FCTREE_H_
+#define _FCTREE_H_
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "rbtree.h"
+
+typedef enum {
+  FC_INSERT,
+  FC_FIND,
+  FC_ERASE
+} fc_op;
+
+// 스레드 하나가 쓰는 슬롯. 다른 스레드의 슬롯과 캐시 라인을 나눠 쓰지 않도록 64바이트로 맞춘다.
+// pending이 true인 동안은 combiner가 op/key를 읽고 result를 쓴다.
+typedef struct {
+  alignas(64) atomic_bool pending;
+  fc_op op;
+  key_t key;
+  int result;
+} fc_slot;
+
+typedef struct {
+  rbtree *tree;
+  atomic_bool combining;
+  atomic_int registered;
+  int nslots;
+  fc_slot *slots;
+  int *batch;  // combiner가 밀린 연산을 모아 정렬할 때 쓰는 슬롯 번호 배열
+} fctree;
+
+// 스레드를 최대 nslots개까지 받는 트리를 만든다
+fctree *new_fctree(const int nslots);
+void delete_fctree(fctree *);
+
+// 호출한 스레드가 쓸 슬롯 번호를 받는다. 슬롯이 다 찼으면 -1을 반환한다.
+int fctree_register(fctree *);
+
+// 모두 slot을 등록한 스레드에서만 부른다. 노드 포인터는 다른 스레드가 바로 지울 수 있으므로 넘기지 않는다.
+// insert는 성공하면 0, 메모리가 부족하면 -1을 반환한다.
+// find와 erase는 키가 있었으면 1, 없었으면 0을 반환한다. erase는 같은 키 중 하나만 지운다.
+int fctree_insert(fctree *, const int, const key_t);
+int fctree_find(fctree *, const int, const key_t);
+int fctree_erase(fctree *, const int, const key_t);
+
+#endif  // _FCTREE_H_
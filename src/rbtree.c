@@ -1,21 +1,86 @@
 #include "rbtree.h"
+#include "rbtree_internal.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/mman.h>
 
 // 필요한 enum을 추가로 정의한다
 typedef enum {
   LEFT,
   RIGHT
 } direction;
+// 병렬 순회에서 한 스레드가 가져가는 작업 단위. single이면 node 하나만, 아니면 node를 루트로 하는 서브트리 전체를 맡는다.
+typedef struct {
+  node_t *node;
+  bool single;
+  size_t count;
+  size_t offset;
+} scan_item;
+
+typedef enum {
+  SCAN_VISIT,
+  SCAN_COUNT,
+  SCAN_EXPORT
+} scan_mode;
+
+// 작업 스레드들이 공유하는 상태. next를 원자적으로 증가시키면서 남은 작업을 하나씩 가져간다
+typedef struct {
+  const rbtree *t;
+  scan_item *items;
+  size_t n_items;
+  atomic_size_t next;
+  scan_mode mode;
+  rbtree_visit_fn fn;
+  void *ctx;
+  key_t *arr;
+  size_t n;
+} scan_job;
+
+// rbtree_clone의 전위순회 스택 크기. 노드 수가 2^63개를 넘지 않으면 트리 높이는 이보다 낮다
+#define CLONE_STACK_SIZE 128
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+#ifdef RBTREE_STATS
+size_t rbtree_rotations = 0;
+#endif
+
 // 필요한 함수를 추가로 정의한다
+void init_nil(node_t *nil);
+void init_balance(rbtree *t, node_t *curr);
 void insert_fixup(node_t *curr, rbtree *t);
+void copy_balance(node_t *dst, const node_t *src);
+bool erase_needs_fixup(const node_t *removed);
+void delete_fixup(rbtree *t, node_t *target);
 void rotate_dir(node_t *curr, direction dir, rbtree *t);
 void transplant(rbtree *t, node_t *pre, node_t *post);
-node_t *return_successor(rbtree *t, node_t *p);
-void delete_fixup(rbtree *t, node_t *target);
-void inorder_trav (const rbtree *t, node_t *start, key_t *arr, int *i, const int n);
+bool in_pool(const rbtree *t, const node_t *p);
+void copy_preorder(rbtree *dst, const rbtree *src);
+node_t *alloc_block(size_t n);
+node_t *compact_resume(const rbtree *t);
+node_t *move_node(rbtree *t, node_t *p);
+node_t *first_node(const rbtree *t);
+int flush_const(const rbtree *t);
+node_t *find_node(const rbtree *t, const key_t key);
+node_t *take_buffered(const rbtree *t, size_t i);
+int compare_keys(const void *p1, const void *p2);
+size_t index_hash(const rbtree *t, key_t key);
+int index_add(rbtree *t, node_t *p);
+void index_remove(rbtree *t, node_t *p);
+void index_replace(rbtree *t, node_t *old, node_t *p);
+node_t *return_predecessor(const rbtree *t, node_t *p);
+int index_rebuild(rbtree *t, size_t cap);
+node_t *subtree_successor(const rbtree *t, const node_t *sub, node_t *p);
+void split_tree(const rbtree *t, node_t *p, int depth, scan_item *items, size_t *n_items);
+void *scan_worker(void *arg);
+int run_scan(scan_job *job, int nthreads);
+scan_item *make_scan_items(const rbtree *t, int nthreads, size_t *n_items);
+bool in_block(const node_t *block, size_t n, const node_t *p);
 
 rbtree *new_rbtree(void) {
   // rbtree 타입의 포인터 p를 선언하고 메모리 할당
@@ -35,7 +100,7 @@ rbtree *new_rbtree(void) {
     return NULL;
   }
   // 초기값을 할당한다
-  p->nil->color = RBTREE_BLACK;
+  init_nil(p->nil);
   p->nil->left = p->nil;
   p->nil->right = p->nil;
   // 루트는 초기에 닐노드를 가리키도록 한다
@@ -48,47 +113,84 @@ void delete_rbtree(rbtree *t) {
   // TODO: reclaim the tree nodes's memory
 
   // 루트부터 트리를 '후위순회'하면서 각 노드에 할당된 메모리를 모두 해제한다.
-  // curr, prev 노드를 정의한다
+  // 스택 대신 parent 포인터를 따라 올라가므로 트리 높이와 상관없이 추가 메모리가 필요 없다.
   node_t *curr = t->root;
-  node_t *prev = NULL;
-  
-  // 스택을 정의한다
-  node_t *stack[20]; //일단 20으로 잡는다. 나중에 realloc등을 사용해서 크기를 조정할 필요가 있다
-  int top = -1; //스택의 최상위 인덱스, 비어있으면 -1
-
-  // 현재 노드가 nil이 아니거나 스택에 요소가 있을 때
-  while (curr != t->nil || top != -1) {
-    // 왼쪽 서브트리로 내려가면서 닐노드를 만날때까지 노드를 스택에 넣는다
-    while (curr != t->nil) {
-      stack[++top] = curr;
+  while (curr != t->nil) {
+    // 자식이 있으면 먼저 내려간다
+    if (curr->left != t->nil) {
       curr = curr->left;
     }
-    // 현재 스택에서 노드를 pop한다
-    curr = stack[top];
-
-    // 팝한 노드의 오른쪽 자식이 없거나, 이미 방문한 경우 자식이 없는것이 확정이므로 현재 메모리를 해제한다
-    if (curr->right == t->nil || curr->right == prev) {
-      free(curr);
-      top--;
-      prev = curr;
-      curr = t->nil;
-    // 오른쪽으로 계속 내려간다
-    } 
-    else {
+    else if (curr->right != t->nil) {
       curr = curr->right;
     }
+    // 리프면 부모와의 연결을 끊고 해제한 뒤 부모로 올라간다
+    else {
+      node_t *parent = curr->parent;
+      if (parent != t->nil) {
+        if (parent->left == curr) {
+          parent->left = t->nil;
+        }
+        else {
+          parent->right = t->nil;
+        }
+      }
+      if (!in_pool(t, curr)){
+        free(curr);
+      }
+      curr = parent;
+    }
   }
-  // 남은 메모리 해제(nil, t)
+  // 남은 메모리 해제(buffer, index, pool, compact_block, nil, t)
+  free(t->buffer);
+  free(t->index);
+  free(t->pool);
+  free(t->compact_block);
   free(t->nil);
   free(t);
 }
 
 node_t *rbtree_insert(rbtree *t, const key_t key) {
+  // 버퍼 모드에서는 키를 버퍼 뒤에 붙이기만 하고, 버퍼가 차면 한꺼번에 트리에 넣는다
+  if (t->buffer){
+    // 지난번 flush가 메모리 부족으로 실패했으면 버퍼가 아직 차 있다. 다시 비워보고, 그래도 자리가 없으면 쓰지 않고 실패한다
+    if (t->buffer_len >= t->buffer_cap){
+      rbtree_flush(t);
+      if (t->buffer_len >= t->buffer_cap){
+        return NULL;
+      }
+    }
+    t->buffer[t->buffer_len++] = key;
+    // 여기서 flush가 실패해도 key는 버퍼에 남아 있다가 다음 flush에 들어간다
+    if (t->buffer_len == t->buffer_cap){
+      rbtree_flush(t);
+    }
+    return t->root;
+  }
+  if (!insert_node(t, t->nil, key)){
+    return NULL;
+  }
+  return t->root;
+}
+
+// key를 가진 노드를 만들어 트리에 넣고 그 노드를 반환한다.
+// hint가 nil이 아니면 루트 대신 hint에서 출발해서, key가 들어갈 수 있는 가장 가까운 조상부터 내려간다.
+node_t *insert_node(rbtree *t, node_t *hint, const key_t key) {
   // 삽입할 위치를 찾는다.
   node_t *curr = t->root;
   node_t *parent = t->nil;
   bool is_right = false;
 
+  // hint보다 작지 않은 키는 hint가 왼쪽 자식인 첫 조상의 키보다 작으면 그 서브트리 안에 들어간다
+  if (hint != t->nil && key >= hint->key){
+    curr = hint;
+    while (curr->parent != t->nil){
+      if (curr == curr->parent->left && key < curr->parent->key){
+        break;
+      }
+      curr = curr->parent;
+    }
+  }
+
   while (curr != t->nil){
     // parent는 따로 받아둔다
     parent = curr;
@@ -109,15 +211,25 @@ node_t *rbtree_insert(rbtree *t, const key_t key) {
   if (!curr){
     return NULL;
   }
-  curr->color = RBTREE_RED;
   curr->key = key;
+  link_node(t, parent, curr, is_right);
+  // 인덱스가 켜져 있으면 같이 등록한다. 인덱스를 키우지 못하면 인덱스를 끄고 트리 탐색으로 돌아간다
+  if (t->index && index_add(t, curr) != 0){
+    rbtree_disable_index(t);
+  }
+  return curr;
+}
+
+// 새 노드 curr을 parent의 자식 자리(nil)에 붙이고 균형을 맞춘다.
+// 키 비교로 자리를 찾는 것은 호출하는 쪽의 몫이라, 키 타입이 다른 트리(strtree)도 이 함수를 같이 쓴다.
+void link_node(rbtree *t, node_t *parent, node_t *curr, bool is_right){
+  t->size++;
   curr->parent = parent;
   curr->left = t->nil;
   curr->right = t->nil;
   // 해당 노드가 루트인지 아닌지에 따라 처리를 다르게 한다
   if (curr->parent == t->nil){
     t->root = curr;
-    curr->color = RBTREE_BLACK;
   }else{
     if (is_right){
       parent->right = curr;
@@ -126,19 +238,40 @@ node_t *rbtree_insert(rbtree *t, const key_t key) {
       parent->left = curr;
     }
   }
-  // 삽입한 후 부모가 레드라서 레드-레드 충돌이 생기는 경우 추가적인 픽스가 필요하다. 따로 함수를 정의한다.
-  if (curr->parent->color == RBTREE_RED){
-    insert_fixup(curr, t);
-  }
-  
-  return t->root;
+  // 삽입한 후 균형이 깨지는 경우(RB라면 레드-레드 충돌) 추가적인 픽스가 필요하다. 따로 함수를 정의한다.
+  init_balance(t, curr);
+  insert_fixup(curr, t);
 }
 
 node_t *rbtree_find(const rbtree *t, const key_t key) {
+  // flush가 실패해서 버퍼에 키가 남아 있으면, 트리에 없는 키는 버퍼에서도 찾아본다
+  bool pending = flush_const(t) != 0;
+  node_t *p = find_node(t, key);
+  for (size_t i = 0; p == NULL && pending && i < t->buffer_len; i++){
+    if (t->buffer[i] == key){
+      p = take_buffered(t, i);
+      break;
+    }
+  }
+  return p;
+}
+
+// rbtree_find와 같지만 버퍼는 보지 않고 트리(인덱스)만 찾는다
+node_t *find_node(const rbtree *t, const key_t key) {
+  // 인덱스가 켜져 있으면 빈 슬롯을 만날 때까지 선형 탐침한다
+  if (t->index){
+    size_t mask = t->index_cap - 1;
+    for (size_t i = index_hash(t, key); t->index[i].node != NULL; i = (i + 1) & mask){
+      if (t->index[i].key == key){
+        return t->index[i].node;
+      }
+    }
+    return NULL;
+  }
   // nil노드를 찾을때까지 bt의 정의에 따라 노드를 서칭한다
   node_t *curr = t->root;
-  // 루트와 키값이 같으면 바로 반환한다
-  if (curr->key == key){
+  // 루트와 키값이 같으면 바로 반환한다. 빈 트리면 루트가 nil이고 nil의 키는 0이므로 걸러낸다
+  if (curr != t->nil && curr->key == key){
     return curr;
   }
   while (curr != t->nil){
@@ -157,6 +290,25 @@ node_t *rbtree_find(const rbtree *t, const key_t key) {
 }
 
 node_t *rbtree_min(const rbtree *t) {
+  bool pending = flush_const(t) != 0;
+  node_t *p = first_node(t);
+  // flush가 실패해서 버퍼에 남은 키가 트리의 최소값보다 작으면, 그 키만 트리에 넣어서 반환한다
+  if (pending){
+    size_t min = 0;
+    for (size_t i = 1; i < t->buffer_len; i++){
+      if (t->buffer[i] < t->buffer[min]){
+        min = i;
+      }
+    }
+    if (p == NULL || t->buffer[min] < p->key){
+      p = take_buffered(t, min);
+    }
+  }
+  return p;
+}
+
+// rbtree_min과 같지만 버퍼를 비우지 않는다. 버퍼를 비우는 도중에도 쓰는 내부 순회용이다
+node_t *first_node(const rbtree *t) {
   node_t *curr = t->root;
   while (curr != t->nil){
     if (curr->left == t->nil){
@@ -169,22 +321,41 @@ node_t *rbtree_min(const rbtree *t) {
 }
 
 node_t *rbtree_max(const rbtree *t) {
+  bool pending = flush_const(t) != 0;
+  node_t *p = NULL;
   node_t *curr = t->root;
   while (curr != t->nil){
     if (curr->right == t->nil){
-      return curr;
+      p = curr;
+      break;
     }
     curr = curr->right;
   }
+  // rbtree_min과 같이, 버퍼에 남은 키가 트리의 최대값보다 크면 그 키만 트리에 넣어서 반환한다
+  if (pending){
+    size_t max = 0;
+    for (size_t i = 1; i < t->buffer_len; i++){
+      if (t->buffer[i] > t->buffer[max]){
+        max = i;
+      }
+    }
+    if (p == NULL || t->buffer[max] > p->key){
+      p = take_buffered(t, max);
+    }
+  }
   // 최대값 못찾으면 NULL(ex. root가 nil인 경우)
-  return NULL;
+  return p;
 }
 
 int rbtree_erase(rbtree *t, node_t *p) {
   // 삭제 노드의 대체 노드, 대체 노드의 대체 노드, fixup 노드를 정의한다
   // fix-up은 target을 대상으로 한다.
   node_t *replacer, *replacer2, *target;
-  int deleted_color = p->color;
+  bool needs_fixup = erase_needs_fixup(p);
+  // 인덱스는 p의 이웃 노드를 봐야 하므로 p를 떼어내기 전에 갱신한다
+  if (t->index){
+    index_remove(t, p);
+  }
 
   // p의 왼쪽 자식이 없는 경우
   if (p->left == t->nil){
@@ -203,7 +374,7 @@ int rbtree_erase(rbtree *t, node_t *p) {
     replacer2 = replacer->right;
     // 찾은 노드에서 추가적으로 필요한 작업
     target = replacer2;
-    deleted_color = replacer->color;
+    needs_fixup = erase_needs_fixup(replacer);
 
     // replacer가 삭제노드의 자녀인 경우, 왼쪽 자식이 없기 때문에 그냥 올려버리면 끝
     if (replacer->parent == p){
@@ -211,7 +382,7 @@ int rbtree_erase(rbtree *t, node_t *p) {
       // 이식후에 왼쪽자식과의 관계를 업데이트한다
       replacer->left = p->left;
       replacer->left->parent = replacer;
-      replacer->color = p->color;
+      copy_balance(replacer, p);
       // 이건 왜하는지 모르겠지만? replacer2의 부모를 replacer로 설정한다
       replacer2->parent = replacer;
       
@@ -225,16 +396,19 @@ int rbtree_erase(rbtree *t, node_t *p) {
       replacer->right->parent = replacer;
       replacer->left = p->left;
       replacer->left->parent = replacer;
-      replacer->color = p->color;
+      copy_balance(replacer, p);
     }
   }
 
-  // 만약 위 과정에서 블랙 노드를 삭제했다면, 추가적인 fixup이 필요하다
-  if (deleted_color == RBTREE_BLACK){
+  // 만약 위 과정에서 떼어낸 노드 때문에 균형이 깨졌다면(RB라면 블랙 노드를 삭제했다면), 추가적인 fixup이 필요하다
+  if (needs_fixup){
     delete_fixup(t, target);
   }
-  // 할당되었던 메모리를 해제한다
-  free(p);
+  t->size--;
+  // 할당되었던 메모리를 해제한다. pool 안의 노드는 블록째로 해제되므로 건너뛴다
+  if (!in_pool(t, p)){
+    free(p);
+  }
   return 0;
 }
 
@@ -243,79 +417,561 @@ int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
   // - RB tree의 내용을 *key 순서대로* 주어진 array로 변환 > key 오름차순 얘기하는듯? 뭔말인지 잘 모르겠음
   // - array의 크기는 n으로 주어지며 tree의 크기가 n 보다 큰 경우에는 순서대로 n개 까지만 변환
   // - array의 메모리 공간은 이 함수를 부르는 쪽에서 준비하고 그 크기를 n으로 알려줍니다.
-  int i = 0;
-  inorder_trav(t, t->root, arr, &i, n);
+  // 재귀 대신 최소 노드부터 successor를 따라가므로 스택을 쓰지 않고, 인덱스는 size_t라 2^31개를 넘어도 된다.
+  // 버퍼를 다 비우지 못했으면 빠지는 키가 생기므로 실패를 알린다
+  if (flush_const(t) != 0){
+    return -1;
+  }
+  node_t *curr = first_node(t);
+  for (size_t i = 0; i < n && curr != NULL; i++){
+    arr[i] = curr->key;
+    curr = return_successor(t, curr);
+  }
   return 0;
 }
 
-void inorder_trav(const rbtree *t, node_t *start, key_t *arr, int *ptr_i, const int n){
-  if (start == t->nil || *ptr_i >= n){
-    return;
-  }else{
-  inorder_trav(t, start->left, arr, ptr_i, n);
-  arr[*ptr_i] = start->key;
-  (*ptr_i)++;
-  inorder_trav(t, start->right, arr, ptr_i, n);
+int rbtree_parallel_foreach(const rbtree *t, rbtree_visit_fn fn, void *ctx, int nthreads) {
+  if (flush_const(t) != 0){
+    return -1;
   }
+  scan_job job = {.t = t, .mode = SCAN_VISIT, .fn = fn, .ctx = ctx};
+  job.items = make_scan_items(t, nthreads, &job.n_items);
+  if (!job.items){
+    return -1;
+  }
+  run_scan(&job, nthreads);
+  free(job.items);
+  return 0;
 }
 
+int rbtree_to_array_parallel(const rbtree *t, key_t *arr, const size_t n, int nthreads) {
+  if (flush_const(t) != 0){
+    return -1;
+  }
+  scan_job job = {.t = t, .mode = SCAN_COUNT, .arr = arr, .n = n};
+  job.items = make_scan_items(t, nthreads, &job.n_items);
+  if (!job.items){
+    return -1;
+  }
+  // 1단계: 서브트리마다 노드 수를 센다
+  run_scan(&job, nthreads);
+  // 노드 수의 누적합으로 각 서브트리가 써야 할 배열 위치를 정한다
+  size_t offset = 0;
+  for (size_t i = 0; i < job.n_items; i++){
+    job.items[i].offset = offset;
+    offset += job.items[i].count;
+  }
+  // 2단계: 각자 정해진 위치부터 키를 쓴다
+  job.mode = SCAN_EXPORT;
+  atomic_store(&job.next, 0);
+  run_scan(&job, nthreads);
+  free(job.items);
+  return 0;
+}
 
-void insert_fixup(node_t *curr, rbtree *t){
-  node_t *parent, *grandparent, *uncle;
+// 스레드 수보다 충분히 많은 작업으로 쪼개서, 먼저 끝난 스레드가 남은 작업을 가져가도록 한다
+scan_item *make_scan_items(const rbtree *t, int nthreads, size_t *n_items){
+  int depth = 0;
+  while (depth < 16 && (1 << depth) < 8 * nthreads){
+    depth++;
+  }
+  // 깊이 depth까지 자르면 서브트리 2^depth개와 그 위의 노드 2^depth - 1개가 나온다
+  scan_item *items = (scan_item *)malloc(((size_t)2 << depth) * sizeof(scan_item));
+  if (!items){
+    return NULL;
+  }
+  *n_items = 0;
+  split_tree(t, t->root, depth, items, n_items);
+  return items;
+}
 
-  while (curr->parent->color == RBTREE_RED){
-    parent = curr->parent;
-    grandparent = parent->parent;
-    // 만약 parent가 왼쪽 자식이면
-    if (parent == grandparent->left){
-      uncle = grandparent->right;
-      // 삼촌이 레드인 경우 레드를 위로 올리고 curr = gp로 변경한다
-      if (uncle->color == RBTREE_RED){
-        uncle->color = RBTREE_BLACK;
-        parent->color = RBTREE_BLACK;
-        grandparent->color = RBTREE_RED;
-        curr = grandparent;
-      // 삼촌이 블랙인 경우
+// 깊이 depth까지 중위순회하면서, 그 위의 노드는 단일 작업으로, 그 아래는 서브트리 작업으로 순서대로 담는다
+void split_tree(const rbtree *t, node_t *p, int depth, scan_item *items, size_t *n_items){
+  if (p == t->nil){
+    return;
+  }
+  if (depth == 0){
+    items[(*n_items)++] = (scan_item){.node = p, .single = false};
+    return;
+  }
+  split_tree(t, p->left, depth - 1, items, n_items);
+  items[(*n_items)++] = (scan_item){.node = p, .single = true};
+  split_tree(t, p->right, depth - 1, items, n_items);
+}
+
+// 호출한 스레드도 작업에 참여하므로 nthreads - 1개만 새로 만든다
+int run_scan(scan_job *job, int nthreads){
+  if (nthreads < 1){
+    nthreads = 1;
+  }
+  pthread_t *threads = (pthread_t *)malloc((size_t)nthreads * sizeof(pthread_t));
+  int started = 0;
+  if (threads){
+    while (started < nthreads - 1 && pthread_create(&threads[started], NULL, scan_worker, job) == 0){
+      started++;
+    }
+  }
+  // 스레드 생성에 실패해도 남은 작업은 여기서 모두 처리된다
+  scan_worker(job);
+  for (int i = 0; i < started; i++){
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  return started + 1;
+}
+
+void *scan_worker(void *arg){
+  scan_job *job = (scan_job *)arg;
+  const rbtree *t = job->t;
+  size_t i;
+  while ((i = atomic_fetch_add(&job->next, 1)) < job->n_items){
+    scan_item *item = &job->items[i];
+    // 서브트리의 가장 왼쪽 노드부터 중위순회한다
+    node_t *curr = item->node;
+    if (!item->single){
+      while (curr->left != t->nil){
+        curr = curr->left;
+      }
+    }
+    size_t count = 0;
+    size_t idx = item->offset;
+    while (curr != NULL){
+      if (job->mode == SCAN_VISIT){
+        job->fn(curr, job->ctx);
+      }else if (job->mode == SCAN_COUNT){
+        count++;
       }else{
-        // 꺾였으면 회전처리부터 한다
-        if (curr == curr->parent->right){
-        curr = parent;
-        rotate_dir(curr, LEFT, t);
-        parent = curr->parent;
-        grandparent = parent->parent;
+        if (idx >= job->n){
+          break;
         }
-        // 펴진 상태에서 마지막 회전 처리를 한다
-        parent->color = RBTREE_BLACK;
-        grandparent->color = RBTREE_RED;
-        rotate_dir(grandparent, RIGHT, t);
+        job->arr[idx++] = curr->key;
       }
-    // parent가 오른쪽 자식이면
+      curr = item->single ? NULL : subtree_successor(t, item->node, curr);
+    }
+    if (job->mode == SCAN_COUNT){
+      item->count = count;
+    }
+  }
+  return NULL;
+}
+
+// return_successor와 같지만, sub를 루트로 하는 서브트리를 벗어나면 NULL을 반환한다
+node_t *subtree_successor(const rbtree *t, const node_t *sub, node_t *p){
+  if (p->right != t->nil){
+    p = p->right;
+    while (p->left != t->nil){
+      p = p->left;
+    }
+    return p;
+  }
+  while (p != sub){
+    if (p->parent->left == p){
+      return p->parent;
+    }
+    p = p->parent;
+  }
+  return NULL;
+}
+
+int rbtree_compact(rbtree *t) {
+  // 진행 중인 단계적 압축이 있으면 그것을 마저 끝내고, 없으면 새로 시작해서 한 번에 끝낸다
+  int r;
+  do {
+    r = rbtree_compact_step(t, SIZE_MAX);
+  } while (r > 0);
+  return r;
+}
+
+int rbtree_compact_step(rbtree *t, size_t budget) {
+  if (rbtree_flush(t) != 0){
+    return -1;
+  }
+  // 새로 시작하는 경우 지금 노드 수만큼의 블록을 잡는다
+  if (!t->compact_block){
+    if (t->size == 0){
+      free(t->pool);
+      t->pool = NULL;
+      t->pool_size = 0;
+      return 0;
+    }
+    t->compact_block = alloc_block(t->size);
+    if (!t->compact_block){
+      return -1;
+    }
+    t->compact_cap = t->size;
+    t->compact_len = 0;
+  }
+
+  // 지난 단계에서 멈춘 곳을 키로 다시 찾는다. 그 사이에 노드가 지워지거나 회전해도 커서가 무효가 되지 않는다
+  // 블록이 다 찬 뒤에는 같은 키의 노드들을 한 단계 안에서 끝까지 훑는다(compact_resume 참고)
+  node_t *curr = t->compact_len == 0 ? first_node(t) : compact_resume(t);
+  while (curr != NULL && (budget > 0 || (t->compact_len == t->compact_cap && curr->key == t->compact_key))){
+    curr = move_node(t, curr);
+    if (!curr){
+      return -1;
+    }
+    t->compact_key = curr->key;
+    curr = return_successor(t, curr);
+    if (budget > 0){
+      budget--;
+    }
+  }
+  if (curr != NULL){
+    return 1;
+  }
+  // 끝까지 훑었으면 옛 pool에 살아있는 노드는 없으므로 블록째로 해제하고 새 블록을 pool로 삼는다
+  free(t->pool);
+  t->pool = t->compact_block;
+  t->pool_size = t->compact_cap;
+  t->compact_block = NULL;
+  t->compact_cap = 0;
+  t->compact_len = 0;
+  return 0;
+}
+
+// 아직 옮기지 않은 첫 노드를 찾는다. 키가 compact_key보다 작거나, 같으면서 이미 새 블록에 있는 노드가 '옮긴 쪽'이다.
+// 같은 키끼리는 옮긴 노드들이 중위순회에서 항상 앞쪽에 모여 있으므로(새로 넣은 같은 키는 오른쪽 끝에 붙는다) lower bound처럼 내려가면 된다.
+// 블록이 다 찼으면 옮기지 않고 지나친 노드와 아직 안 본 노드를 구분할 수 없으므로, compact_key까지는 다 훑었다고 보고 upper bound로 내려간다
+node_t *compact_resume(const rbtree *t){
+  bool full = t->compact_len == t->compact_cap;
+  node_t *curr = t->root;
+  node_t *found = NULL;
+  while (curr != t->nil){
+    if (curr->key < t->compact_key || (curr->key == t->compact_key && (full || in_block(t->compact_block, t->compact_cap, curr)))){
+      curr = curr->right;
     }else{
-      uncle = grandparent->left;
-      if (uncle->color == RBTREE_RED){
-        uncle->color = RBTREE_BLACK;
-        parent->color = RBTREE_BLACK;
-        grandparent->color = RBTREE_RED;
-        curr = grandparent;
-      }else{
-        if (curr == curr->parent->left){
-        curr = parent;
-        rotate_dir(curr, RIGHT, t);
-        parent = curr->parent;
-        grandparent = parent->parent;
-        }
-        parent->color = RBTREE_BLACK;
-        grandparent->color = RBTREE_RED;
-        rotate_dir(grandparent, LEFT, t);
+      found = curr;
+      curr = curr->left;
+    }
+  }
+  return found;
+}
+
+// p를 새 블록의 다음 칸으로 옮기고 새 주소를 반환한다. 부모의 자식 포인터, 자식들의 부모 포인터, 루트만 고치면 된다.
+// 그 사이 삽입이 많아서 블록이 다 찼으면, 옛 pool의 노드는 개별 할당으로 옮기고(pool을 해제해야 하므로) 나머지는 그대로 둔다.
+// 할당에 실패하면 트리를 건드리지 않고 NULL을 반환한다
+node_t *move_node(rbtree *t, node_t *p){
+  node_t *q;
+  if (t->compact_len < t->compact_cap){
+    q = &t->compact_block[t->compact_len++];
+  }else if (in_block(t->pool, t->pool_size, p)){
+    q = (node_t *)malloc(sizeof(node_t));
+    if (!q){
+      return NULL;
+    }
+  }else{
+    return p;
+  }
+  *q = *p;
+  if (p->parent == t->nil){
+    t->root = q;
+  }else if (p->parent->left == p){
+    p->parent->left = q;
+  }else{
+    p->parent->right = q;
+  }
+  if (q->left != t->nil){
+    q->left->parent = q;
+  }
+  if (q->right != t->nil){
+    q->right->parent = q;
+  }
+  if (t->index){
+    index_replace(t, p, q);
+  }
+  if (!in_pool(t, p)){
+    free(p);
+  }
+  return q;
+}
+
+rbtree *rbtree_clone(const rbtree *t) {
+  if (flush_const(t) != 0){
+    return NULL;
+  }
+  size_t n = t->size;
+  rbtree *c = new_rbtree();
+  if (!c){
+    return NULL;
+  }
+  if (n > 0){
+    c->pool = alloc_block(n);
+    if (!c->pool){
+      delete_rbtree(c);
+      return NULL;
+    }
+    c->pool_size = n;
+    copy_preorder(c, t);
+    c->size = n;
+  }
+  // 인덱스와 버퍼 설정도 원본을 따른다
+  if ((t->index && rbtree_enable_index(c) != 0) || (t->buffer && rbtree_set_buffer(c, t->buffer_cap) != 0)){
+    delete_rbtree(c);
+    return NULL;
+  }
+  return c;
+}
+
+// 노드 n개짜리 블록을 할당한다. 큰 블록은 2MiB huge page로 받아서, 처음 쓸 때의 페이지 폴트 수를 줄인다
+node_t *alloc_block(size_t n){
+  size_t bytes = n * sizeof(node_t);
+#ifdef MADV_HUGEPAGE
+  if (bytes >= HUGE_PAGE_SIZE){
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    node_t *block = (node_t *)aligned_alloc(HUGE_PAGE_SIZE, bytes);
+    if (block){
+      madvise(block, bytes, MADV_HUGEPAGE);
+    }
+    return block;
+  }
+#endif
+  return (node_t *)malloc(bytes);
+}
+
+// src 트리를 dst->pool 블록에 전위순회 순서로 복사해서 dst의 트리로 만든다.
+// 왼쪽으로 내려가면서 복사하고, 나중에 복사할 오른쪽 자식만 스택에 쌓는다. 스택에는 레벨마다 많아야 하나가 쌓이므로
+// 트리 높이(2 * log2(n + 1) 이하)만큼이면 충분하다
+void copy_preorder(rbtree *dst, const rbtree *src){
+  struct {
+    const node_t *src;
+    node_t *parent;
+    node_t **slot;
+  } stack[CLONE_STACK_SIZE];
+  size_t top = 0;
+  node_t *block = dst->pool;
+  size_t i = 0;
+  const node_t *curr = src->root;
+  node_t *parent = dst->nil;
+  node_t **slot = &dst->root;
+  while (true){
+    while (curr != src->nil){
+      node_t *q = &block[i++];
+      q->key = curr->key;
+      copy_balance(q, curr);
+      q->parent = parent;
+      q->left = dst->nil;
+      q->right = dst->nil;
+      *slot = q;
+      if (curr->right != src->nil){
+        // 오른쪽 자식은 왼쪽 서브트리를 다 복사한 뒤에 쓰므로 미리 캐시로 불러둔다
+        __builtin_prefetch(curr->right);
+        stack[top].src = curr->right;
+        stack[top].parent = q;
+        stack[top].slot = &q->right;
+        top++;
       }
+      parent = q;
+      slot = &q->left;
+      curr = curr->left;
     }
+    if (top == 0){
+      break;
+    }
+    top--;
+    curr = stack[top].src;
+    parent = stack[top].parent;
+    slot = stack[top].slot;
   }
-  // 루트의 색을 블랙으로 변경한다
-  t->root->color = RBTREE_BLACK;
+}
+
+int rbtree_set_buffer(rbtree *t, const size_t cap) {
+  // 크기를 바꾸기 전에 남아 있는 키를 모두 트리에 넣는다
+  if (rbtree_flush(t) != 0){
+    return -1;
+  }
+  free(t->buffer);
+  t->buffer = NULL;
+  t->buffer_cap = 0;
+  if (cap == 0){
+    return 0;
+  }
+  t->buffer = (key_t *)malloc(cap * sizeof(key_t));
+  if (!t->buffer){
+    return -1;
+  }
+  t->buffer_cap = cap;
+  return 0;
+}
+
+int rbtree_flush(rbtree *t) {
+  if (t->buffer_len == 0){
+    return 0;
+  }
+  // 정렬해서 넣으면 매번 루트부터 내려가지 않고, 직전에 넣은 노드에서 가까운 조상부터 내려갈 수 있다
+  qsort(t->buffer, t->buffer_len, sizeof(key_t), compare_keys);
+  node_t *hint = t->nil;
+  size_t i;
+  for (i = 0; i < t->buffer_len; i++){
+    hint = insert_node(t, hint, t->buffer[i]);
+    if (!hint){
+      break;
+    }
+  }
+  // 메모리가 부족해서 중간에 멈췄으면 못 넣은 키를 버퍼 앞으로 당겨둔다
+  size_t left = t->buffer_len - i;
+  memmove(t->buffer, t->buffer + i, left * sizeof(key_t));
+  t->buffer_len = left;
+  return left == 0 ? 0 : -1;
+}
+
+// 읽기 연산은 const rbtree를 받지만, 버퍼에 남은 키가 보이도록 먼저 트리에 반영해야 한다.
+// 트리 자체는 new_rbtree가 만든 const가 아닌 객체이므로 const를 떼어내도 안전하다.
+// 메모리가 부족해서 버퍼에 키가 남았으면 -1을 반환한다. 호출한 쪽은 남은 키를 직접 보거나 실패를 알려야 한다
+int flush_const(const rbtree *t){
+  if (t->buffer_len != 0){
+    return rbtree_flush((rbtree *)t);
+  }
+  return 0;
+}
+
+// 버퍼의 i번째 키 하나만 트리에 넣고 그 노드를 반환한다. 그것도 할당하지 못하면 키를 버퍼에 둔 채 NULL을 반환한다
+node_t *take_buffered(const rbtree *t, size_t i){
+  rbtree *w = (rbtree *)t;
+  node_t *p = insert_node(w, w->nil, w->buffer[i]);
+  if (p){
+    w->buffer[i] = w->buffer[--w->buffer_len];
+  }
+  return p;
+}
+
+int compare_keys(const void *p1, const void *p2){
+  key_t k1 = *(const key_t *)p1;
+  key_t k2 = *(const key_t *)p2;
+  return (k1 > k2) - (k1 < k2);
+}
+
+int rbtree_enable_index(rbtree *t) {
+  if (t->index){
+    return 0;
+  }
+  if (rbtree_flush(t) != 0){
+    return -1;
+  }
+  // 노드 수의 두 배 이상이 되도록 슬롯 수를 정한다
+  size_t n = t->size;
+  size_t cap = 16;
+  while (cap < 2 * n){
+    cap <<= 1;
+  }
+  return index_rebuild(t, cap);
+}
+
+void rbtree_disable_index(rbtree *t) {
+  free(t->index);
+  t->index = NULL;
+  t->index_cap = 0;
+  t->index_len = 0;
+}
+
+// 피보나치 해싱: 키를 섞은 뒤 상위 비트를 슬롯 번호로 쓴다
+size_t index_hash(const rbtree *t, key_t key){
+  uint64_t h = (uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ULL;
+  return (size_t)(h >> 32) & (t->index_cap - 1);
+}
+
+// 슬롯 수가 cap인 새 인덱스를 할당하고 트리의 모든 노드를 다시 등록한다. 실패하면 기존 인덱스를 그대로 둔다
+int index_rebuild(rbtree *t, size_t cap){
+  index_slot *slots = (index_slot *)calloc(cap, sizeof(index_slot));
+  if (!slots){
+    return -1;
+  }
+  free(t->index);
+  t->index = slots;
+  t->index_cap = cap;
+  t->index_len = 0;
+  for (node_t *p = first_node(t); p != NULL; p = return_successor(t, p)){
+    index_add(t, p);
+  }
+  return 0;
+}
+
+// 키마다 슬롯은 하나뿐이다. 이미 같은 키의 슬롯이 있으면 그 노드를 그대로 둔다
+int index_add(rbtree *t, node_t *p){
+  size_t mask = t->index_cap - 1;
+  size_t i = index_hash(t, p->key);
+  while (t->index[i].node != NULL){
+    if (t->index[i].key == p->key){
+      return 0;
+    }
+    i = (i + 1) & mask;
+  }
+  // 부하율이 1/2을 넘으면 슬롯 수를 두 배로 늘린다(index_rebuild가 p도 이미 등록한다)
+  if (2 * (t->index_len + 1) > t->index_cap){
+    return index_rebuild(t, t->index_cap * 2);
+  }
+  t->index[i].key = p->key;
+  t->index[i].node = p;
+  t->index_len++;
+  return 0;
+}
+
+// 트리에서 떼어내기 전의 p를 인덱스에서 뺀다. 슬롯이 p를 가리키고 있으면, 같은 키의 노드는 중위순회에서 붙어 있으므로
+// 앞뒤 이웃 중 같은 키인 노드로 옮긴다. 그런 노드가 없을 때만 슬롯을 지우고,
+// 뒤따르는 슬롯들을 앞으로 당겨서(backward shift) 탐침 체인이 끊기지 않게 한다
+void index_remove(rbtree *t, node_t *p){
+  size_t mask = t->index_cap - 1;
+  size_t i = index_hash(t, p->key);
+  while (t->index[i].key != p->key){
+    i = (i + 1) & mask;
+  }
+  if (t->index[i].node != p){
+    return;
+  }
+  node_t *next = return_successor(t, p);
+  if (next == NULL || next->key != p->key){
+    next = return_predecessor(t, p);
+  }
+  if (next != NULL && next->key == p->key){
+    t->index[i].node = next;
+    return;
+  }
+  size_t j = i;
+  while (true){
+    j = (j + 1) & mask;
+    if (t->index[j].node == NULL){
+      break;
+    }
+    // j 슬롯의 원래 자리 k가 (i, j] 구간 밖에 있을 때만 i로 옮길 수 있다
+    size_t k = index_hash(t, t->index[j].key);
+    if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))){
+      t->index[i] = t->index[j];
+      i = j;
+    }
+  }
+  t->index[i].node = NULL;
+  t->index_len--;
+}
+
+// rbtree_compact_step이 노드를 옮긴 뒤 인덱스 슬롯이 새 주소를 가리키게 한다
+void index_replace(rbtree *t, node_t *old, node_t *p){
+  size_t mask = t->index_cap - 1;
+  for (size_t i = index_hash(t, p->key); t->index[i].node != NULL; i = (i + 1) & mask){
+    if (t->index[i].key == p->key){
+      if (t->index[i].node == old){
+        t->index[i].node = p;
+      }
+      return;
+    }
+  }
+}
+
+// p가 블록째로 할당된 노드인지 확인한다(pool, 그리고 압축이 진행 중이면 새로 채우는 블록)
+bool in_pool(const rbtree *t, const node_t *p){
+  return in_block(t->pool, t->pool_size, p) || in_block(t->compact_block, t->compact_cap, p);
+}
+
+// 서로 다른 할당 간의 포인터 비교를 피하기 위해 정수 주소로 비교한다
+bool in_block(const node_t *block, size_t n, const node_t *p){
+  uintptr_t addr = (uintptr_t)p;
+  uintptr_t start = (uintptr_t)block;
+  return block != NULL && addr >= start && addr < start + n * sizeof(node_t);
 }
 
 void rotate_dir(node_t *curr, direction dir, rbtree *t){
   node_t *child;
+#ifdef RBTREE_STATS
+  rbtree_rotations++;
+#endif
   // 왼쪽회전
   if (dir == LEFT){
     child = curr->right;
@@ -374,7 +1030,25 @@ void transplant(rbtree *t, node_t *pre, node_t *post){
   post->parent = pre->parent;
 }
 
-node_t *return_successor(rbtree *t, node_t *p){
+// p 바로 앞의 노드를 반환한다. 없으면 NULL.
+node_t *return_predecessor(const rbtree *t, node_t *p){
+  if (p->left == t->nil){
+    while (p->parent != t->nil){
+      if (p->parent->right == p){
+        return p->parent;
+      }
+      p = p->parent;
+    }
+    return NULL;
+  }
+  node_t *predecessor = p->left;
+  while (predecessor->right != t->nil){
+    predecessor = predecessor->right;
+  }
+  return predecessor;
+}
+
+node_t *return_successor(const rbtree *t, node_t *p){
   if (p->right == t->nil){
     while (p->parent != t->nil){
       if (p->parent->left == p){
@@ -393,6 +1067,91 @@ node_t *return_successor(rbtree *t, node_t *p){
   }
 }
 
+// ---------------------------------------------------------------------------
+// 균형 엔진
+// 이진 탐색 트리 연산(삽입 위치 찾기, 떼어내기)은 엔진과 상관없이 위에서 처리하고,
+// 노드의 균형 정보를 다루는 아래 함수들만 컴파일 시점에 RBTREE_WAVL로 골라 쓴다.
+//   init_nil          nil 노드의 균형 정보를 초기화한다
+//   init_balance      새로 붙인 노드의 균형 정보를 초기화한다
+//   insert_fixup      새 노드를 붙인 뒤 균형을 맞춘다
+//   copy_balance      삭제할 노드 자리에 들어가는 노드가 그 균형 정보를 물려받는다
+//   erase_needs_fixup 떼어낸 노드 때문에 균형을 다시 맞춰야 하는지 판단한다(정보를 물려주기 전에 부른다)
+//   delete_fixup      떼어낸 자리를 대신한 target(nil일 수 있음, parent는 transplant가 맞춰둔다)부터 균형을 맞춘다
+// ---------------------------------------------------------------------------
+#ifndef RBTREE_WAVL
+
+void init_nil(node_t *nil){
+  nil->color = RBTREE_BLACK;
+}
+
+// 새 노드는 레드로 붙인다. 루트라면 insert_fixup 마지막에 블랙으로 바뀐다
+void init_balance(rbtree *t, node_t *curr){
+  curr->color = RBTREE_RED;
+}
+
+void copy_balance(node_t *dst, const node_t *src){
+  dst->color = src->color;
+}
+
+// 블랙 노드를 떼어내면 black-height가 하나 줄어드므로 fixup이 필요하다
+bool erase_needs_fixup(const node_t *removed){
+  return removed->color == RBTREE_BLACK;
+}
+
+void insert_fixup(node_t *curr, rbtree *t){
+  node_t *parent, *grandparent, *uncle;
+
+  while (curr->parent->color == RBTREE_RED){
+    parent = curr->parent;
+    grandparent = parent->parent;
+    // 만약 parent가 왼쪽 자식이면
+    if (parent == grandparent->left){
+      uncle = grandparent->right;
+      // 삼촌이 레드인 경우 레드를 위로 올리고 curr = gp로 변경한다
+      if (uncle->color == RBTREE_RED){
+        uncle->color = RBTREE_BLACK;
+        parent->color = RBTREE_BLACK;
+        grandparent->color = RBTREE_RED;
+        curr = grandparent;
+      // 삼촌이 블랙인 경우
+      }else{
+        // 꺾였으면 회전처리부터 한다
+        if (curr == curr->parent->right){
+        curr = parent;
+        rotate_dir(curr, LEFT, t);
+        parent = curr->parent;
+        grandparent = parent->parent;
+        }
+        // 펴진 상태에서 마지막 회전 처리를 한다
+        parent->color = RBTREE_BLACK;
+        grandparent->color = RBTREE_RED;
+        rotate_dir(grandparent, RIGHT, t);
+      }
+    // parent가 오른쪽 자식이면
+    }else{
+      uncle = grandparent->left;
+      if (uncle->color == RBTREE_RED){
+        uncle->color = RBTREE_BLACK;
+        parent->color = RBTREE_BLACK;
+        grandparent->color = RBTREE_RED;
+        curr = grandparent;
+      }else{
+        if (curr == curr->parent->left){
+        curr = parent;
+        rotate_dir(curr, RIGHT, t);
+        parent = curr->parent;
+        grandparent = parent->parent;
+        }
+        parent->color = RBTREE_BLACK;
+        grandparent->color = RBTREE_RED;
+        rotate_dir(grandparent, LEFT, t);
+      }
+    }
+  }
+  // 루트의 색을 블랙으로 변경한다
+  t->root->color = RBTREE_BLACK;
+}
+
 void delete_fixup(rbtree *t, node_t *target){
   // target이 root거나 레드가 될 때까지 반복한다. 이유는 앞의 두 케이스는 삭제된 블랙을 복구하는게 매우 단순해짐.
   while (target != t->root && target->color == RBTREE_BLACK) {
@@ -479,4 +1238,111 @@ void delete_fixup(rbtree *t, node_t *target){
   return;
 }
 
-// }
\ No newline at end of file
+#else  // RBTREE_WAVL
+
+// WAVL(weak AVL) 트리: 각 노드가 랭크를 가지고, 부모와 자식의 랭크 차이(rank difference)는 1 또는 2,
+// 리프의 랭크는 0이어야 한다. nil의 랭크는 -1로 둔다.
+// 삽입은 AVL과 같이 동작하고, 삭제는 회전이 최대 2번이며 승강(promote/demote)도 상각 O(1)이다.
+// 삭제만 있을 때도 높이가 2log(n)을 넘지 않고, 삽입만 있었다면 AVL과 같이 1.44log(n) 이하이다.
+
+void init_nil(node_t *nil){
+  nil->rank = -1;
+}
+
+void init_balance(rbtree *t, node_t *curr){
+  curr->rank = 0;
+}
+
+void copy_balance(node_t *dst, const node_t *src){
+  dst->rank = src->rank;
+}
+
+// 어떤 노드를 떼어내도 부모의 랭크 차이가 3이 되거나 부모가 랭크 1짜리 리프가 될 수 있으므로 항상 확인한다
+bool erase_needs_fixup(const node_t *removed){
+  return true;
+}
+
+void insert_fixup(node_t *curr, rbtree *t){
+  node_t *parent = curr->parent;
+  // curr의 랭크가 부모와 같은(랭크 차이 0) 동안 반복한다
+  while (parent != t->nil && parent->rank == curr->rank){
+    bool is_left = (curr == parent->left);
+    node_t *sibling = is_left ? parent->right : parent->left;
+    // 형제가 1-자식이면 부모를 승급시키고 위로 올라간다
+    if (parent->rank - sibling->rank == 1){
+      parent->rank++;
+      curr = parent;
+      parent = curr->parent;
+      continue;
+    }
+    // 형제가 2-자식이면 회전으로 끝낸다. 형제 쪽을 향한 curr의 안쪽 자식에 따라 단일/이중 회전을 고른다
+    node_t *inner = is_left ? curr->right : curr->left;
+    if (curr->rank - inner->rank == 2){
+      rotate_dir(parent, is_left ? RIGHT : LEFT, t);
+      parent->rank--;
+    }else{
+      rotate_dir(curr, is_left ? LEFT : RIGHT, t);
+      rotate_dir(parent, is_left ? RIGHT : LEFT, t);
+      inner->rank++;
+      curr->rank--;
+      parent->rank--;
+    }
+    break;
+  }
+}
+
+void delete_fixup(rbtree *t, node_t *target){
+  node_t *parent = target->parent;
+  if (parent == t->nil){
+    return;
+  }
+  // 리프를 떼어내서 부모가 랭크 1짜리 리프(2,2 리프)가 되었으면 랭크 0으로 강등한다
+  if (target == t->nil && parent->left == t->nil && parent->right == t->nil){
+    if (parent->rank == 1){
+      parent->rank = 0;
+    }
+    target = parent;
+    parent = target->parent;
+  }
+  // target이 3-자식인 동안 반복한다
+  while (parent != t->nil && parent->rank - target->rank == 3){
+    bool is_left = (target == parent->left);
+    node_t *sibling = is_left ? parent->right : parent->left;
+    // 형제가 2-자식이면 부모만 강등시키고 위로 올라간다
+    if (parent->rank - sibling->rank == 2){
+      parent->rank--;
+      target = parent;
+      parent = target->parent;
+      continue;
+    }
+    node_t *outer = is_left ? sibling->right : sibling->left;
+    node_t *inner = is_left ? sibling->left : sibling->right;
+    // 형제의 자식이 모두 2-자식이면 부모와 형제를 같이 강등시키고 위로 올라간다
+    if (sibling->rank - outer->rank == 2 && sibling->rank - inner->rank == 2){
+      parent->rank--;
+      sibling->rank--;
+      target = parent;
+      parent = target->parent;
+      continue;
+    }
+    // 바깥쪽 자식이 1-자식이면 단일 회전, 아니면 안쪽 자식을 올리는 이중 회전으로 끝낸다
+    if (sibling->rank - outer->rank == 1){
+      rotate_dir(parent, is_left ? LEFT : RIGHT, t);
+      sibling->rank++;
+      parent->rank--;
+      // 회전 후 parent가 리프가 되었으면 랭크 0이어야 한다
+      if (parent->left == t->nil && parent->right == t->nil){
+        parent->rank--;
+      }
+    }else{
+      rotate_dir(sibling, is_left ? RIGHT : LEFT, t);
+      rotate_dir(parent, is_left ? LEFT : RIGHT, t);
+      inner->rank += 2;
+      sibling->rank--;
+      parent->rank -= 2;
+    }
+    break;
+  }
+}
+
+#endif  // RBTREE_WAVL
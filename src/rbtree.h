@@ -9,18 +9,51 @@ typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
 typedef int key_t;
 
 // 구조체 node_t를 선언한다. 멤버로 색, 키, 연결된 노드의 포인터들을 가진다
+// RBTREE_WAVL로 컴파일하면 균형 엔진이 WAVL로 바뀌고, 색 대신 랭크를 가진다(nil의 랭크는 -1).
 typedef struct node_t {
+#ifdef RBTREE_WAVL
+  int rank;
+#else
   color_t color;
+#endif
   key_t key;
   struct node_t *parent, *left, *right;
 } node_t;
 
+// 해시 인덱스의 슬롯. node가 NULL이면 빈 슬롯이다.
+// 키를 슬롯에 같이 들고 있어서, 탐침할 때 노드까지 따라가지 않아도 된다.
+typedef struct {
+  key_t key;
+  node_t *node;
+} index_slot;
+
 // 구조체 rbtree를 선언한다.
 // root 포인터는 rbtree 전체를 순회하기 위해 필요하다.
 // nil 포인터는 하나만 선언한다. 개념적으로 nil노드는 여러개이지만, 어차피 같은 속성이므로 하나만 선언해두고 다 여기를 가리키게 한다.
+// pool은 rbtree_compact가 노드들을 재배치해둔 연속 메모리 블록이고, pool_size는 그 블록의 노드 수이다.
+// pool 안의 노드는 개별적으로 free하지 않고 블록째로 해제한다.
+// size는 트리에 들어있는 노드 수이다(버퍼에 남은 키는 세지 않는다).
 typedef struct {
   node_t *root;
   node_t *nil;  // for sentinel
+  size_t size;
+  node_t *pool;
+  size_t pool_size;
+  // compact_block은 rbtree_compact_step이 진행 중일 때 노드를 옮겨 담는 새 블록이다(진행 중이 아니면 NULL).
+  // compact_cap칸 중 compact_len칸을 채웠고, compact_key는 마지막으로 옮긴 노드의 키이다.
+  node_t *compact_block;
+  size_t compact_cap;
+  size_t compact_len;
+  key_t compact_key;
+  // index는 rbtree_enable_index로 켜는 선택적 해시 인덱스다(꺼져 있으면 NULL).
+  // index_cap은 슬롯 수(2의 거듭제곱), index_len은 채워진 슬롯 수이다. 슬롯은 서로 다른 키마다 하나씩이고, 그 키의 노드 중 하나를 가리킨다.
+  index_slot *index;
+  size_t index_cap;
+  size_t index_len;
+  // buffer는 rbtree_set_buffer로 켜는 삽입 버퍼다(꺼져 있으면 NULL). 아직 트리에 넣지 않은 키가 buffer_len개 들어있다.
+  key_t *buffer;
+  size_t buffer_cap;
+  size_t buffer_len;
 } rbtree;
 
 // rbtree를 반환하는, new_rbtree 함수를 선언한다. 인자는 받지 않는다.
@@ -41,4 +74,41 @@ int rbtree_erase(rbtree *, node_t *);
 
 int rbtree_to_array(const rbtree *, key_t *, const size_t);
 
+// 트리의 모양과 균형 정보를 그대로 복사한 새 트리를 반환한다. 키 비교나 재균형 없이 O(n)이고,
+// 모든 노드를 한 번에 할당한 블록에 담는다(rbtree_compact와 같은 pool). 실패하면 NULL을 반환한다.
+rbtree *rbtree_clone(const rbtree *);
+
+// 삽입 버퍼를 cap 크기로 켠다(0이면 끈다). 켜져 있으면 rbtree_insert는 키를 버퍼에 쌓기만 하고,
+// 버퍼가 차거나 find/min/max/to_array 같은 읽기 연산이 오면 정렬해서 한꺼번에 트리에 넣는다.
+// 버퍼 모드의 rbtree_insert는 새 노드 대신 현재 루트를 반환한다.
+// 읽기 연산도 버퍼를 비우면서 트리를 바꾸므로, 여러 스레드에서 동시에 읽으려면 먼저 rbtree_flush를 불러야 한다.
+// 메모리가 부족해서 버퍼를 다 비우지 못하면 find/min/max는 남은 키를 직접 찾아보고, to_array/clone/병렬 순회는 실패를 반환한다.
+int rbtree_set_buffer(rbtree *, const size_t);
+int rbtree_flush(rbtree *);
+
+// 키 -> 노드 해시 인덱스를 켜고 끈다. 켜져 있으면 insert/erase가 인덱스도 같이 갱신하고,
+// rbtree_find는 트리를 내려가지 않고 인덱스에서 바로 찾는다. 중복 키는 그 중 아무 노드나 반환한다.
+int rbtree_enable_index(rbtree *);
+void rbtree_disable_index(rbtree *);
+
+#ifdef RBTREE_STATS
+// 지금까지 수행한 회전 수. 균형 엔진끼리 비교할 때 쓴다
+extern size_t rbtree_rotations;
+#endif
+
+// 트리를 서로 겹치지 않는 서브트리들로 쪼개서 nthreads개의 스레드로 나눠 처리한다.
+// foreach의 fn은 여러 스레드에서 동시에, 순서 없이 호출되므로 ctx 접근은 fn 쪽에서 동기화해야 한다.
+// to_array_parallel은 서브트리마다 출력 위치를 미리 계산해두므로 결과는 rbtree_to_array와 같다.
+typedef void (*rbtree_visit_fn)(node_t *, void *);
+int rbtree_parallel_foreach(const rbtree *, rbtree_visit_fn, void *, int);
+int rbtree_to_array_parallel(const rbtree *, key_t *, const size_t, int);
+
+// 모든 노드를 하나의 연속 블록에 키 순서대로 다시 배치해서 탐색 시 캐시 지역성을 되살린다.
+// 노드 주소가 바뀌므로, 호출 전에 받아둔 node_t 포인터는 모두 무효가 된다.
+// 실패하면 -1을 반환한다. 트리는 올바른 상태로 남고, 다시 부르면 이어서 진행한다.
+int rbtree_compact(rbtree *);
+// rbtree_compact를 나눠서 한 번에 최대 budget개의 노드만 옮긴다. 단계 사이에 insert/erase를 해도 된다.
+// 남은 노드가 있으면 1, 끝났으면 0, 실패하면 -1을 반환한다. 옮긴 노드의 주소는 바뀐다.
+int rbtree_compact_step(rbtree *, size_t);
+
 #endif  // _RBTREE_H_
@@ -0,0 +1,18 @@
+// rbtree.c 안의 함수 중, rbtree 위에 만든 다른 모듈(strtree, fctree 등)이 같이 쓰는 것들을 선언한다.
+// 라이브러리 사용자가 쓰는 헤더가 아니다.
+#ifndef _RBTREE_INTERNAL_H_
+#define _RBTREE_INTERNAL_H_
+
+#include <stdbool.h>
+
+#include "rbtree.h"
+
+// 새 노드를 parent의 왼쪽/오른쪽(is_right) 빈 자리에 붙이고 균형을 맞춘다.
+void link_node(rbtree *t, node_t *parent, node_t *curr, bool is_right);
+// key를 가진 노드를 만들어 넣고 그 노드를 반환한다(삽입 버퍼는 거치지 않는다).
+// 정렬된 키를 차례로 넣을 때는 직전에 넣은 노드를 hint로 주면 루트 대신 그 근처에서부터 내려간다. 없으면 t->nil.
+node_t *insert_node(rbtree *t, node_t *hint, const key_t key);
+// p 다음으로 큰 노드를 반환한다. 없으면 NULL.
+node_t *return_successor(const rbtree *t, node_t *p);
+
+#endif  // _RBTREE_INTERNAL_H_
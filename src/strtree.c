@@ -0,0 +1,192 @@
+#include "strtree.h"
+#include "rbtree_internal.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// arena 청크 하나의 기본 크기. 이보다 긴 키는 자기 크기만큼의 청크를 따로 받는다
+#define STRCHUNK_SIZE (64 * 1024)
+
+// 필요한 함수를 추가로 정의한다
+uint64_t load_prefix(const char *key, const size_t len);
+int compare_key(const strnode_t *p, uint64_t prefix, const char *key, const size_t len, const size_t skip);
+char *arena_alloc(strtree *st, const size_t len);
+size_t common_len(const char *a, const size_t a_len, const char *b, const size_t b_len);
+void shrink_shared(strtree *st, const size_t shared_len);
+
+strtree *new_strtree(void) {
+  strtree *st = (strtree *)calloc(1, sizeof(strtree));
+  if (!st){
+    return NULL;
+  }
+  st->tree = new_rbtree();
+  if (!st->tree){
+    free(st);
+    return NULL;
+  }
+  return st;
+}
+
+void delete_strtree(strtree *st) {
+  // 노드는 rbtree가 해제하고, 키 바이트는 arena 청크째로 해제한다
+  delete_rbtree(st->tree);
+  while (st->chunks){
+    strchunk_t *next = st->chunks->next;
+    free(st->chunks);
+    st->chunks = next;
+  }
+  free(st);
+}
+
+strnode_t *strtree_insert(strtree *st, const char *key, const size_t len) {
+  rbtree *t = st->tree;
+  // 공유 접두사와 어긋나는 키면 공유 접두사를 줄이고 노드들의 prefix를 다시 계산한다
+  if (t->root != t->nil){
+    size_t shared_len = common_len(st->shared, st->shared_len, key, len);
+    if (shared_len < st->shared_len){
+      shrink_shared(st, shared_len);
+    }
+  }
+  size_t skip = t->root == t->nil ? len : st->shared_len;
+  uint64_t prefix = load_prefix(key + skip, len - skip);
+  node_t *curr = t->root;
+  node_t *parent = t->nil;
+  bool is_right = false;
+
+  // rbtree_insert와 같이 내려가되, 비교는 prefix부터 한다. 같으면 오른쪽으로 간다
+  while (curr != t->nil){
+    parent = curr;
+    is_right = compare_key((strnode_t *)curr, prefix, key, len, skip) >= 0;
+    curr = is_right ? curr->right : curr->left;
+  }
+
+  strnode_t *p = (strnode_t *)calloc(1, sizeof(strnode_t));
+  if (!p){
+    return NULL;
+  }
+  char *bytes = arena_alloc(st, len);
+  if (!bytes){
+    free(p);
+    return NULL;
+  }
+  memcpy(bytes, key, len);
+  // 빈 트리에 넣는 첫 키는 키 전체가 공유 접두사이다
+  if (t->root == t->nil){
+    st->shared = bytes;
+    st->shared_len = len;
+  }
+  p->prefix = prefix;
+  p->len = len;
+  p->bytes = bytes;
+  link_node(t, parent, &p->node, is_right);
+  return p;
+}
+
+strnode_t *strtree_find(const strtree *st, const char *key, const size_t len) {
+  const rbtree *t = st->tree;
+  // 공유 접두사로 시작하지 않는 키는 트리에 없다
+  if (t->root == t->nil || len < st->shared_len || memcmp(key, st->shared, st->shared_len) != 0){
+    return NULL;
+  }
+  size_t skip = st->shared_len;
+  uint64_t prefix = load_prefix(key + skip, len - skip);
+  node_t *curr = t->root;
+  while (curr != t->nil){
+    int cmp = compare_key((strnode_t *)curr, prefix, key, len, skip);
+    if (cmp == 0){
+      return (strnode_t *)curr;
+    }else if (cmp > 0){
+      curr = curr->right;
+    }else{
+      curr = curr->left;
+    }
+  }
+  return NULL;
+}
+
+strnode_t *strtree_min(const strtree *st) {
+  return (strnode_t *)rbtree_min(st->tree);
+}
+
+strnode_t *strtree_max(const strtree *st) {
+  return (strnode_t *)rbtree_max(st->tree);
+}
+
+int strtree_erase(strtree *st, strnode_t *p) {
+  // node가 첫 멤버이므로 rbtree_erase가 free하는 주소가 곧 strnode_t의 주소이다
+  return rbtree_erase(st->tree, &p->node);
+}
+
+// 앞 8바이트를 빅엔디안으로 읽는다. 키가 8바이트보다 짧으면 나머지는 0이다
+uint64_t load_prefix(const char *key, const size_t len){
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < 8; i++){
+    prefix <<= 8;
+    if (i < len){
+      prefix |= (unsigned char)key[i];
+    }
+  }
+  return prefix;
+}
+
+// 찾는 키(prefix, key, len)가 노드 p의 키보다 작으면 음수, 같으면 0, 크면 양수를 반환한다.
+// 두 키 모두 앞 skip바이트가 같아야 하고, prefix는 그 다음 8바이트이다
+int compare_key(const strnode_t *p, uint64_t prefix, const char *key, const size_t len, const size_t skip){
+  // 대부분은 노드 안의 prefix만으로 결판이 난다
+  if (prefix != p->prefix){
+    return prefix > p->prefix ? 1 : -1;
+  }
+  // prefix가 같고 둘 중 하나라도 skip + 8바이트 이하면, 짧은 쪽이 긴 쪽의 접두사이므로 길이만 비교하면 된다.
+  // 둘 다 더 길 때만 arena에 있는 나머지 바이트를 읽는다
+  size_t min_len = len < p->len ? len : p->len;
+  if (min_len > skip + 8){
+    int cmp = memcmp(key + skip + 8, p->bytes + skip + 8, min_len - skip - 8);
+    if (cmp != 0){
+      return cmp;
+    }
+  }
+  if (len == p->len){
+    return 0;
+  }
+  return len > p->len ? 1 : -1;
+}
+
+// 두 바이트열의 공통 접두사 길이
+size_t common_len(const char *a, const size_t a_len, const char *b, const size_t b_len){
+  size_t n = a_len < b_len ? a_len : b_len;
+  size_t i = 0;
+  while (i < n && a[i] == b[i]){
+    i++;
+  }
+  return i;
+}
+
+// 공유 접두사를 shared_len바이트로 줄이고, 모든 노드의 prefix를 새 위치에서 다시 읽는다
+void shrink_shared(strtree *st, const size_t shared_len){
+  rbtree *t = st->tree;
+  for (node_t *curr = rbtree_min(t); curr != NULL; curr = return_successor(t, curr)){
+    strnode_t *p = (strnode_t *)curr;
+    p->prefix = load_prefix(p->bytes + shared_len, p->len - shared_len);
+  }
+  st->shared_len = shared_len;
+}
+
+// 현재 청크에 자리가 없으면 새 청크를 앞에 붙인다
+char *arena_alloc(strtree *st, const size_t len){
+  strchunk_t *chunk = st->chunks;
+  if (!chunk || chunk->cap - chunk->used < len){
+    size_t cap = len > STRCHUNK_SIZE ? len : STRCHUNK_SIZE;
+    chunk = (strchunk_t *)malloc(sizeof(strchunk_t) + cap);
+    if (!chunk){
+      return NULL;
+    }
+    chunk->used = 0;
+    chunk->cap = cap;
+    chunk->next = st->chunks;
+    st->chunks = chunk;
+  }
+  char *bytes = (char *)(chunk + 1) + chunk->used;
+  chunk->used += len;
+  return bytes;
+}
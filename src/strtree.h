@@ -0,0 +1,49 @@
+// 가변 길이 바이트 문자열을 키로 쓰는 트리. 균형은 rbtree와 같은 코드로 맞춘다.
+#ifndef _STRTREE_H_
+#define _STRTREE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+
+// 노드에 키의 8바이트(prefix)와 길이를 같이 넣어둔다. 모든 키가 공유하는 앞부분(strtree의 shared)은 비교할 필요가 없으므로,
+// prefix는 키의 앞 8바이트가 아니라 shared_len바이트 다음의 8바이트이다.
+// prefix는 빅엔디안으로 묶어서 정수 비교가 곧 사전순 비교가 되게 하고, 부족한 바이트는 0으로 채운다.
+// prefix가 같을 때만 arena에 있는 전체 키(bytes)를 읽는다.
+// node는 반드시 첫 멤버여야 한다(node_t 포인터와 strnode_t 포인터를 서로 바꿔 쓴다).
+typedef struct {
+  node_t node;
+  uint64_t prefix;
+  size_t len;
+  const char *bytes;
+} strnode_t;
+
+// 키 바이트를 담아두는 arena 청크. 청크 뒤에 데이터가 바로 붙어 있다.
+typedef struct strchunk_t {
+  struct strchunk_t *next;
+  size_t used, cap;
+} strchunk_t;
+
+// shared는 트리에 넣은 모든 키가 공유하는 접두사로, 그 길이가 shared_len이다(arena 안의 어느 키의 앞부분을 가리킨다).
+// 공유 접두사가 짧아지는 키가 들어오면 모든 노드의 prefix를 한 번에 다시 계산한다.
+typedef struct {
+  rbtree *tree;
+  strchunk_t *chunks;
+  const char *shared;
+  size_t shared_len;
+} strtree;
+
+strtree *new_strtree(void);
+void delete_strtree(strtree *);
+
+// 키를 arena에 복사해서 넣고, 새로 만든 노드를 반환한다. 같은 키도 하나 더 추가한다.
+strnode_t *strtree_insert(strtree *, const char *, const size_t);
+strnode_t *strtree_find(const strtree *, const char *, const size_t);
+strnode_t *strtree_min(const strtree *);
+strnode_t *strtree_max(const strtree *);
+
+// 노드를 지운다. 키 바이트는 arena에 남아 있다가 delete_strtree에서 한꺼번에 해제된다.
+int strtree_erase(strtree *, strnode_t *);
+
+#endif  // _STRTREE_H_
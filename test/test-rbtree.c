@@ -1,8 +1,14 @@
 #include <assert.h>
 #include <rbtree.h>
+#include <strtree.h>
+#include <fctree.h>
+#include <bmtree.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // new_rbtree should return rbtree struct with null root node
 void test_init(void) {
@@ -217,6 +223,33 @@ void test_search_constraint(const rbtree *t) {
   assert(search_traverse(p, &min, &max, nil));
 }
 
+#ifdef RBTREE_WAVL
+// Rank constraint (WAVL engine)
+// 1. Every rank difference between a parent and its child is 1 or 2.
+// 2. NIL nodes have rank -1, so every leaf has rank 0.
+
+static bool rank_traverse(const node_t *p, node_t *nil) {
+  if (p == nil) {
+    return true;
+  }
+  const int dl = p->rank - p->left->rank;
+  const int dr = p->rank - p->right->rank;
+  if (dl < 1 || dl > 2 || dr < 1 || dr > 2) {
+    return false;
+  }
+  if (p->left == nil && p->right == nil && p->rank != 0) {
+    return false;
+  }
+  return rank_traverse(p->left, nil) && rank_traverse(p->right, nil);
+}
+
+// the WAVL engine checks its rank rule in place of the color rule
+void test_color_constraint(const rbtree *t) {
+  assert(t != NULL);
+  assert(t->nil->rank == -1);
+  assert(rank_traverse(t->root, t->nil));
+}
+#else
 // Color constraint
 // 1. Each node is either red or black. (by definition)
 // 2. All NIL nodes are considered black.
@@ -264,6 +297,7 @@ void test_color_constraint(const rbtree *t) {
   init_color_traverse();
   assert(color_traverse(p, RBTREE_BLACK, 0, nil));
 }
+#endif
 
 // rbtree should keep search tree and color constraints
 void test_rb_constraints(const key_t arr[], const size_t n) {
@@ -279,6 +313,30 @@ void test_rb_constraints(const key_t arr[], const size_t n) {
   delete_rbtree(t);
 }
 
+// constraints should also hold in the middle of mixed inserts and erases
+void test_erase_constraints(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++) {
+    rbtree_insert(t, rand() % 1000);
+    if (i % 3 == 2) {
+      node_t *p = rbtree_find(t, rand() % 1000);
+      if (p != NULL) {
+        rbtree_erase(t, p);
+      }
+    }
+    if (i % 100 == 0) {
+      test_color_constraint(t);
+      test_search_constraint(t);
+    }
+  }
+  while (t->root != t->nil) {
+    rbtree_erase(t, t->root);
+    test_color_constraint(t);
+  }
+  delete_rbtree(t);
+}
+
 // rbtree should manage distinct values
 void test_distinct_values() {
   const key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
@@ -366,6 +424,547 @@ void test_find_erase_rand(const size_t n, const unsigned int seed) {
   delete_rbtree(t);
 }
 
+// delete and to_array should not depend on the tree height
+void test_deep_tree(const size_t n) {
+  rbtree *t = new_rbtree();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_insert(t, (key_t)i);
+  }
+  key_t *res = calloc(n, sizeof(key_t));
+  rbtree_to_array(t, res, n);
+  for (size_t i = 0; i < n; i++) {
+    assert(res[i] == (key_t)i);
+  }
+  free(res);
+  delete_rbtree(t);
+}
+
+// compact should keep keys and constraints while relocating every node
+void test_compact(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % 1000;
+    rbtree_insert(t, arr[i]);
+  }
+  // erase half of the keys so that pooled and malloc'ed nodes are mixed
+  for (int i = 0; i < n / 2; i++) {
+    rbtree_erase(t, rbtree_find(t, arr[i]));
+  }
+  assert(rbtree_compact(t) == 0);
+  assert(t->pool != NULL);
+  for (int i = 0; i < n / 2; i++) {
+    rbtree_insert(t, arr[i]);
+  }
+  assert(rbtree_compact(t) == 0);
+  assert(t->pool_size == n);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  key_t *res = calloc(n, sizeof(key_t));
+  rbtree_to_array(t, res, n);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == res[i]);
+  }
+  for (int i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    rbtree_erase(t, p);
+  }
+  assert(t->root == t->nil);
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// compaction in small slices should survive inserts and erases between the slices
+void test_compact_step(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  size_t count[1000] = {0};
+  for (size_t i = 0; i < n; i++) {
+    key_t k = rand() % 1000;
+    rbtree_insert(t, k);
+    count[k]++;
+  }
+  assert(rbtree_compact(t) == 0);
+  assert(rbtree_enable_index(t) == 0);
+  for (size_t i = 0; i < n / 2; i++) {
+    key_t k = rand() % 1000;
+    node_t *p = rbtree_find(t, k);
+    if (p != NULL) {
+      rbtree_erase(t, p);
+      count[k]--;
+    }
+  }
+
+  int r;
+  size_t slices = 0;
+  do {
+    r = rbtree_compact_step(t, 7);
+    assert(r >= 0);
+    slices++;
+    key_t k = rand() % 1000;
+    rbtree_insert(t, k);
+    count[k]++;
+    k = rand() % 1000;
+    node_t *p = rbtree_find(t, k);
+    if (p != NULL) {
+      rbtree_erase(t, p);
+      count[k]--;
+    }
+  } while (r > 0);
+  assert(slices > 1);
+  assert(t->compact_block == NULL);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  key_t *res = calloc(t->size, sizeof(key_t));
+  rbtree_to_array(t, res, t->size);
+  size_t i = 0;
+  for (key_t k = 0; k < 1000; k++) {
+    assert((rbtree_find(t, k) != NULL) == (count[k] > 0));
+    for (size_t j = 0; j < count[k]; j++) {
+      assert(res[i++] == k);
+    }
+  }
+  assert(i == t->size);
+  free(res);
+
+  // a compaction left half-way is finished by rbtree_compact or released by delete_rbtree
+  assert(rbtree_compact_step(t, 5) == 1);
+  assert(rbtree_compact(t) == 0);
+  assert(t->compact_block == NULL);
+  assert(t->pool_size == t->size);
+  assert(rbtree_compact_step(t, 5) == 1);
+  delete_rbtree(t);
+}
+
+static bool same_shape(const node_t *p, const node_t *q, const rbtree *t,
+                       const rbtree *c) {
+  if (p == t->nil || q == c->nil) {
+    return p == t->nil && q == c->nil;
+  }
+#ifdef RBTREE_WAVL
+  const bool same_balance = p->rank == q->rank;
+#else
+  const bool same_balance = p->color == q->color;
+#endif
+  return p != q && p->key == q->key && same_balance &&
+         same_shape(p->left, q->left, t, c) &&
+         same_shape(p->right, q->right, t, c);
+}
+
+// clone should copy the shape into one block and stay independent of the
+// original
+void test_clone(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  rbtree *c = rbtree_clone(t);
+  assert(c != NULL && c->root == c->nil);
+  delete_rbtree(c);
+
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % 1000;
+  }
+  insert_arr(t, arr, n);
+  c = rbtree_clone(t);
+  assert(c != NULL);
+  assert(c->pool_size == n);
+  assert(c->size == n && t->size == n);
+  assert(same_shape(t->root, c->root, t, c));
+  assert(c->root->parent == c->nil);
+  test_color_constraint(c);
+
+  // erasing from the clone should not touch the original
+  for (int i = 0; i < n / 2; i++) {
+    rbtree_erase(c, rbtree_find(c, arr[i]));
+  }
+  assert(c->size == n - n / 2 && t->size == n);
+  for (int i = 0; i < n; i++) {
+    assert(rbtree_find(t, arr[i]) != NULL);
+  }
+  test_color_constraint(c);
+  test_search_constraint(c);
+
+  rbtree *cc = rbtree_clone(c);
+  assert(same_shape(c->root, cc->root, c, cc));
+  delete_rbtree(cc);
+  delete_rbtree(c);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// find should give the same answers with the hash index as without it
+void test_index(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (n / 4);  // plenty of duplicates
+  }
+  insert_arr(t, arr, n / 2);
+  assert(rbtree_enable_index(t) == 0);
+  for (int i = n / 2; i < n; i++) {
+    rbtree_insert(t, arr[i]);
+  }
+  // one slot per distinct key
+  bool *seen = calloc(n / 4, sizeof(bool));
+  size_t distinct = 0;
+  for (int i = 0; i < n; i++) {
+    distinct += !seen[arr[i]];
+    seen[arr[i]] = true;
+  }
+  assert(t->index_len == distinct);
+
+  for (int i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+  }
+  // erase every other key, then relocate the nodes
+  for (int i = 0; i < n; i += 2) {
+    rbtree_erase(t, rbtree_find(t, arr[i]));
+  }
+  assert(rbtree_compact(t) == 0);
+  memset(seen, 0, n / 4 * sizeof(bool));
+  distinct = 0;
+  for (int i = 1; i < n; i += 2) {
+    distinct += !seen[arr[i]];
+    seen[arr[i]] = true;
+  }
+  assert(t->index_len == distinct);
+  for (int i = 1; i < n; i += 2) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+    rbtree_erase(t, p);
+  }
+  assert(t->index_len == 0);
+  for (int i = 0; i < n; i++) {
+    assert(rbtree_find(t, arr[i]) == NULL);
+  }
+  test_color_constraint(t);
+
+  free(seen);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// many copies of one key should share a single slot, so lookups of other keys and
+// erasing the copies one by one never walk a long probe chain
+void test_index_duplicates(const size_t n) {
+  rbtree *t = new_rbtree();
+  assert(rbtree_enable_index(t) == 0);
+  for (size_t i = 0; i < n; i++) {
+    rbtree_insert(t, 7);
+  }
+  rbtree_insert(t, 3);
+  rbtree_insert(t, 11);
+  assert(t->index_len == 3);
+  for (size_t i = 0; i < 4 * n; i++) {
+    key_t k = (key_t)i + 100;
+    assert(rbtree_find(t, k) == NULL);
+  }
+  for (size_t i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, 7);
+    assert(p != NULL && p->key == 7);
+    rbtree_erase(t, p);
+    assert(t->index_len == (i + 1 < n ? 3 : 2));
+  }
+  assert(rbtree_find(t, 7) == NULL);
+  assert(rbtree_find(t, 3)->key == 3);
+  assert(rbtree_find(t, 11)->key == 11);
+  test_color_constraint(t);
+  delete_rbtree(t);
+}
+
+// buffered inserts should be visible to every read
+void test_buffered_insert(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  assert(rbtree_set_buffer(t, 64) == 0);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (n / 2);
+    assert(rbtree_insert(t, arr[i]) != NULL);
+    // reads arrive every now and then in the middle of a burst
+    if (i % 1000 == 999) {
+      node_t *p = rbtree_find(t, arr[i]);
+      assert(p != NULL && p->key == arr[i]);
+      assert(t->buffer_len == 0);
+    }
+  }
+  assert(t->buffer_len == (n % 1000) % 64);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  assert(rbtree_min(t)->key == arr[0]);
+  assert(rbtree_max(t)->key == arr[n - 1]);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  key_t *res = calloc(n, sizeof(key_t));
+  rbtree_to_array(t, res, n);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == res[i]);
+  }
+  // a buffer left full (as after a failed flush) is drained before the next key goes in
+  for (size_t i = t->buffer_len; i < t->buffer_cap; i++) {
+    t->buffer[i] = (key_t)(n + i);
+  }
+  t->buffer_len = t->buffer_cap;
+  assert(rbtree_insert(t, (key_t)(2 * n)) != NULL);
+  assert(t->buffer_len == 1);
+  assert(rbtree_max(t)->key == (key_t)(2 * n));
+  // keys still in the buffer are flushed when the buffer is turned off
+  rbtree_insert(t, -1);
+  assert(rbtree_set_buffer(t, 0) == 0);
+  assert(t->buffer == NULL);
+  assert(rbtree_min(t)->key == -1);
+  rbtree_insert(t, -2);
+  assert(rbtree_min(t)->key == -2);
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
+static int comp_str(const void *p1, const void *p2) {
+  const char *s1 = *(const char **)p1;
+  const char *s2 = *(const char **)p2;
+  return strcmp(s1, s2);
+}
+
+// strtree should order byte strings like memcmp, including keys sharing long prefixes
+void test_strtree(void) {
+  const char *keys[] = {"https://example.com/a",   "https://example.com/b",
+                        "https://example.com/",    "https://example.com/a",
+                        "https://example.org/",    "http",
+                        "https://example.com/abc", "",
+                        "b",                       "https://"};
+  const size_t n = sizeof(keys) / sizeof(keys[0]);
+  strtree *st = new_strtree();
+  assert(st != NULL);
+  for (int i = 0; i < n; i++) {
+    strnode_t *p = strtree_insert(st, keys[i], strlen(keys[i]));
+    assert(p != NULL);
+    assert(p->len == strlen(keys[i]));
+    assert(memcmp(p->bytes, keys[i], p->len) == 0);
+  }
+  test_color_constraint(st->tree);
+
+  const char *sorted[sizeof(keys) / sizeof(keys[0])];
+  memcpy(sorted, keys, sizeof(keys));
+  qsort((void *)sorted, n, sizeof(char *), comp_str);
+  assert(strtree_min(st)->len == 0);
+  assert(strtree_max(st)->len == strlen(sorted[n - 1]));
+
+  for (int i = 0; i < n; i++) {
+    strnode_t *p = strtree_find(st, sorted[i], strlen(sorted[i]));
+    assert(p != NULL);
+    assert(p->len == strlen(sorted[i]));
+    assert(memcmp(p->bytes, sorted[i], p->len) == 0);
+  }
+  assert(strtree_find(st, "https://example.com/ab", 22) == NULL);
+  assert(strtree_find(st, "http\0", 5) == NULL);
+
+  // erase in sorted order, so min should follow the sorted keys
+  for (int i = 0; i < n; i++) {
+    strnode_t *p = strtree_min(st);
+    assert(p->len == strlen(sorted[i]));
+    assert(memcmp(p->bytes, sorted[i], p->len) == 0);
+    strtree_erase(st, p);
+  }
+  assert(strtree_min(st) == NULL);
+
+  delete_strtree(st);
+}
+
+static void check_prefix_order(const rbtree *t, const node_t *p, const strnode_t **prev) {
+  if (p == t->nil) {
+    return;
+  }
+  check_prefix_order(t, p->left, prev);
+  const strnode_t *curr = (const strnode_t *)p;
+  assert(*prev == NULL || (*prev)->prefix < curr->prefix);
+  *prev = curr;
+  check_prefix_order(t, p->right, prev);
+}
+
+// URL keys share a long scheme/host part; the cached prefix should start after it,
+// so distinct keys always differ in the cached bytes and never read the arena
+void test_strtree_shared(const size_t n) {
+  strtree *st = new_strtree();
+  char key[64];
+  for (size_t i = 0; i < n; i++) {
+    int len = snprintf(key, sizeof(key), "https://example.com/items/%06zu", (i * 7919) % n);
+    assert(strtree_insert(st, key, len) != NULL);
+  }
+  assert(st->shared_len == strlen("https://example.com/items/00"));
+  const strnode_t *prev = NULL;
+  check_prefix_order(st->tree, st->tree->root, &prev);
+  for (size_t i = 0; i < n; i++) {
+    int len = snprintf(key, sizeof(key), "https://example.com/items/%06zu", i);
+    strnode_t *p = strtree_find(st, key, len);
+    assert(p != NULL && memcmp(p->bytes, key, len) == 0);
+  }
+  assert(strtree_find(st, "https://example.org/", 20) == NULL);
+
+  // a key outside the shared part shrinks it, and every cached prefix moves
+  assert(strtree_insert(st, "http://example.com/", 19) != NULL);
+  assert(st->shared_len == 4);
+  for (size_t i = 0; i < n; i += 97) {
+    int len = snprintf(key, sizeof(key), "https://example.com/items/%06zu", i);
+    assert(strtree_find(st, key, len) != NULL);
+  }
+  assert(strtree_min(st)->len == 19);
+  test_color_constraint(st->tree);
+  delete_strtree(st);
+}
+
+static void count_visit(node_t *p, void *ctx) {
+  atomic_size_t *visited = (atomic_size_t *)ctx;
+  atomic_fetch_add(visited, 1);
+}
+
+// parallel scans should visit every node once and export keys in order
+void test_parallel_scan(const size_t n, const int nthreads) {
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand();
+  }
+  insert_arr(t, arr, n);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+
+  atomic_size_t visited = 0;
+  assert(rbtree_parallel_foreach(t, count_visit, &visited, nthreads) == 0);
+  assert(visited == n);
+
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array_parallel(t, res, n, nthreads) == 0);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == res[i]);
+  }
+  // a shorter array should get only the first keys
+  memset(res, 0, n * sizeof(key_t));
+  assert(rbtree_to_array_parallel(t, res, n / 3, nthreads) == 0);
+  for (int i = 0; i < n / 3; i++) {
+    assert(arr[i] == res[i]);
+  }
+  assert(n / 3 == n || res[n / 3] == 0);
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// bmtree should give the same answers as a plain multiset while chunks are
+// collapsed into bitmaps and split back
+void test_bmtree(const size_t n, const unsigned int seed) {
+  srand(seed);
+  bmtree *bt = new_bmtree();
+  assert(bt != NULL);
+  key_t k;
+  assert(!bmtree_min(bt, &k) && !bmtree_max(bt, &k));
+
+  // a dense run of ids around zero, sparse keys, and some duplicates
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    if (i % 4 == 3) {
+      arr[i] = rand();
+    } else if (i % 16 == 5) {
+      arr[i] = arr[i - 1];
+    } else {
+      arr[i] = i - (key_t)n / 2;
+    }
+    assert(bmtree_insert(bt, arr[i]) == 0);
+  }
+  assert(bt->size == n);
+  assert(bt->dense > 0);
+  test_color_constraint(bt->tree);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  key_t *res = calloc(n, sizeof(key_t));
+  bmtree_to_array(bt, res, n);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == res[i]);
+    assert(bmtree_find(bt, arr[i]));
+  }
+  assert(bmtree_min(bt, &k) && k == arr[0]);
+  assert(bmtree_max(bt, &k) && k == arr[n - 1]);
+  assert(!bmtree_find(bt, arr[n - 1] + 1));
+
+  // erase all keys in sorted order; dense chunks should split back on the
+  // way down and min should always follow the sorted keys
+  for (int i = 0; i < n; i++) {
+    assert(bmtree_min(bt, &k) && k == arr[i]);
+    assert(bmtree_erase(bt, arr[i]) == 1);
+  }
+  assert(bmtree_erase(bt, arr[0]) == 0);
+  assert(bt->size == 0 && bt->dense == 0);
+  assert(bt->tree->root == bt->tree->nil);
+
+  free(res);
+  free(arr);
+  delete_bmtree(bt);
+}
+
+#define FC_THREADS 8
+#define FC_KEYS 2000
+
+static void *fctree_worker(void *arg) {
+  fctree *ft = (fctree *)arg;
+  const int slot = fctree_register(ft);
+  assert(slot >= 0);
+  // every thread owns the keys congruent to its slot, so results are exact
+  for (int i = 0; i < FC_KEYS; i++) {
+    assert(fctree_insert(ft, slot, i * FC_THREADS + slot) == 0);
+  }
+  for (int i = 0; i < FC_KEYS; i++) {
+    assert(fctree_find(ft, slot, i * FC_THREADS + slot) == 1);
+  }
+  for (int i = 0; i < FC_KEYS; i += 2) {
+    assert(fctree_erase(ft, slot, i * FC_THREADS + slot) == 1);
+    assert(fctree_erase(ft, slot, i * FC_THREADS + slot) == 0);
+  }
+  return NULL;
+}
+
+// flat combining should apply every thread's operations exactly once
+void test_fctree(void) {
+  // key 0 on an empty tree must not match the nil sentinel (whose key is 0)
+  fctree *empty = new_fctree(1);
+  assert(empty != NULL);
+  int slot = fctree_register(empty);
+  assert(slot == 0);
+  assert(fctree_find(empty, slot, 0) == 0);
+  assert(fctree_erase(empty, slot, 0) == 0);
+  assert(empty->tree->root == empty->tree->nil);
+  delete_fctree(empty);
+
+  fctree *ft = new_fctree(FC_THREADS);
+  assert(ft != NULL);
+  pthread_t threads[FC_THREADS];
+  for (int i = 0; i < FC_THREADS; i++) {
+    assert(pthread_create(&threads[i], NULL, fctree_worker, ft) == 0);
+  }
+  for (int i = 0; i < FC_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  assert(fctree_register(ft) == -1);
+  assert(ft->tree->size == FC_THREADS * FC_KEYS / 2);
+  test_color_constraint(ft->tree);
+  test_search_constraint(ft->tree);
+  for (int k = 0; k < FC_THREADS * FC_KEYS; k++) {
+    assert((rbtree_find(ft->tree, k) != NULL) == ((k / FC_THREADS) % 2 == 1));
+  }
+  delete_fctree(ft);
+}
+
 int main(void) {
   test_init();
   test_insert_single(1024);
@@ -376,7 +975,21 @@ int main(void) {
   test_to_array_suite();
   test_distinct_values();
   test_duplicate_values();
+  test_erase_constraints(5000, 17);
   test_multi_instance();
   test_find_erase_rand(10000, 17);
+  test_deep_tree(1 << 20);
+  test_compact(10000, 17);
+  test_compact_step(10000, 17);
+  test_parallel_scan(10000, 4);
+  test_index(10000, 17);
+  test_index_duplicates(50000);
+  test_strtree();
+  test_strtree_shared(10000);
+  test_clone(10000, 17);
+  test_fctree();
+  test_bmtree(10000, 17);
+  test_buffered_insert(10500, 17);
+  test_parallel_scan(3, 8);
   printf("Passed all tests!\n");
 }
\ No newline at end of file